@@ -0,0 +1,111 @@
+// Checks the parallel direction-optimizing BFS against a plain serial BFS.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -Icpp_src/include cpp_src/bench/FewestStopsCheck.cpp
+//       $(ls cpp_src/src/*.cpp | grep -v main.cpp) -o fewest_stops_check -lpthread
+// Run:
+//   ./fewest_stops_check [cities=60000] [routes=300000]
+//
+// The graph is large enough that levels pass PARALLEL_MIN_WORK, and the
+// check allows 4 threads whatever the machine has, so the levels really are
+// split across threads. It then repeats the searches inside WorkerPool jobs,
+// where each one must stay on its own thread. Exits non-zero on the first
+// mismatch.
+
+#include <iostream>
+#include <random>
+#include <cstdlib>
+#include <atomic>
+#include "../include/FewestStops.h"
+#include "../include/WorkerPool.h"
+
+using namespace std;
+
+static vector<int> serialBfs(const CSRGraph& csr, const vector<CityId>& sources) {
+    vector<int> hops(csr.numCities(), -1);
+    CustomQueue<CityId> q;
+    for (CityId s : sources) {
+        if (hops[s] != 0) q.enqueue(s);
+        hops[s] = 0;
+    }
+    while (!q.empty()) {
+        CityId u = q.front();
+        q.dequeue();
+        for (const Edge& e : csr.neighbors(u)) {
+            if (hops[e.dest] >= 0) continue;
+            hops[e.dest] = hops[u] + 1;
+            q.enqueue(e.dest);
+        }
+    }
+    return hops;
+}
+
+int main(int argc, char** argv) {
+    int cities = argc > 1 ? atoi(argv[1]) : 60000;
+    int routes = argc > 2 ? atoi(argv[2]) : 300000;
+
+    mt19937 rng(42);
+    Graph g;
+    vector<string> sources, destinations;
+    vector<int> weights;
+    for (int i = 0; i < routes; ++i) {
+        int a = rng() % cities, b = rng() % cities;
+        sources.push_back("C" + to_string(a));
+        destinations.push_back("C" + to_string(b));
+        weights.push_back(1 + rng() % 100);
+    }
+    g.bulkLoad(sources, destinations, weights);
+    const CSRGraph& csr = g.snapshot();
+
+    WorkerPool::setConcurrency(4);
+    cout << "Threads allowed: " << WorkerPool::threadsHere() << "\n";
+    vector<vector<CityId>> trials;
+    for (int trial = 0; trial < 8; ++trial) {
+        // Single sources, then growing multi-source sets as hopCounts uses
+        vector<CityId> from;
+        for (int k = 0; k <= trial; ++k) from.push_back(rng() % csr.numCities());
+        trials.push_back(from);
+    }
+
+    atomic<int> failures{0};
+    auto check = [&](const vector<CityId>& from) {
+        vector<int> hops;
+        vector<CityId> parents;
+        FewestStops::bfs(csr, from, hops, &parents);
+        vector<int> expected = serialBfs(csr, from);
+        for (CityId c = 0; c < csr.numCities(); ++c) {
+            bool treeOk = hops[c] <= 0 || hops[parents[c]] == hops[c] - 1;
+            if (hops[c] != expected[c] || !treeOk) {
+                cout << "Mismatch at city " << c << " with " << from.size() << " sources: "
+                     << hops[c] << " vs " << expected[c] << "\n";
+                failures++;
+                break;
+            }
+        }
+    };
+    for (const auto& from : trials) check(from);
+
+    // Every worker takes trials off a shared counter, as batchQuery does
+    WorkerPool pool;
+    atomic<size_t> next{0};
+    atomic<int> widened{0};
+    pool.run([&] {
+        if (WorkerPool::threadsHere() != 1) widened++;
+        for (size_t i; (i = next++) < trials.size();) check(trials[i]);
+    });
+    if (widened) {
+        cout << "Pool workers were allowed more than one thread\n";
+        failures++;
+    }
+
+    string a = "C1", b = "C2";
+    FewestStopsResult res = FewestStops::find(g, a, b);
+    vector<int> expected = serialBfs(csr, {g.findCity(a)});
+    if (res.found != (expected[g.findCity(b)] >= 0) || (res.found && res.stops != expected[g.findCity(b)])) {
+        cout << "find(" << a << ", " << b << ") disagrees with the serial BFS\n";
+        failures++;
+    }
+
+    cout << (failures ? "FAILED" : "OK") << "\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+// Allocation microbenchmark for neighbor iteration.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -Icpp_src/include cpp_src/bench/NeighborAllocBench.cpp
+//       $(ls cpp_src/src/*.cpp | grep -v main.cpp) -o neighbor_bench
+//
+// "copy" replays the old getNeighbors contract (a fresh vector<Edge> per call),
+// "range" walks the zero-copy NeighborRange that the algorithms now use.
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include "../include/PathFinder.h"
+
+using namespace std;
+
+static size_t allocCount = 0;
+
+void* operator new(size_t n) {
+    allocCount++;
+    if (void* p = malloc(n)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Sample { double allocsPerQuery; double nsPerQuery; };
+
+template <typename F>
+Sample measure(int queries, F body) {
+    size_t before = allocCount;
+    auto t0 = chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) body(q);
+    auto t1 = chrono::steady_clock::now();
+    return {(double)(allocCount - before) / queries,
+            chrono::duration<double, nano>(t1 - t0).count() / queries};
+}
+
+void report(const string& name, Sample s) {
+    cout << "  " << name << ": " << s.allocsPerQuery << " allocs/query, "
+         << (long long)s.nsPerQuery << " ns/query\n";
+}
+
+int main() {
+    const int hubRoutes = 500;
+    const int queries = 2000;
+
+    Graph g;
+    for (int i = 0; i < hubRoutes; ++i) {
+        g.addEdge("Hub", "Spoke" + to_string(i), 1 + i % 97);
+        g.addEdge("Spoke" + to_string(i), "Spoke" + to_string((i + 1) % hubRoutes), 50);
+    }
+    g.snapshot();
+
+    long long sink = 0;
+    cout << "Walking a hub city with " << hubRoutes << " routes:\n";
+    report("copy ", measure(queries, [&](int) {
+        NeighborRange r = g.getNeighbors("Hub");
+        vector<Edge> copy(r.begin(), r.end());
+        for (const Edge& e : copy) sink += e.weight;
+    }));
+    report("range", measure(queries, [&](int) {
+        for (const Edge& e : g.getNeighbors("Hub")) sink += e.weight;
+    }));
+
+    cout << "Tour over hub + 6 spokes (tspHelper neighbor scans):\n";
+    vector<string> tour = {"Hub", "Spoke1", "Spoke2", "Spoke3", "Spoke4", "Spoke5", "Spoke6"};
+    report("range", measure(20, [&](int) { sink += MultiCityTour::plan(g, tour).totalDistance; }));
+
+    cout << "Shortest path Spoke0 -> Spoke250 (whole query, incl. result):\n";
+    report("range", measure(200, [&](int) { sink += ShortestPath::find(g, "Spoke0", "Spoke250").distance; }));
+
+    cout << "(checksum " << sink << ")\n";
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Picks the fastest Dijkstra queue policy for a given weight distribution.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -Icpp_src/include cpp_src/bench/QueueBench.cpp
+//       $(ls cpp_src/src/*.cpp | grep -v main.cpp) -o queue_bench
+// Run:
+//   ./queue_bench [cities=20000] [routesPerCity=3] [maxWeight=100] [uniform|skewed]
+//
+// "skewed" draws most weights near 1 with a long tail up to maxWeight,
+// which is the road-network shape where Dial buckets tend to win.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "../include/ShortestPath.h"
+
+using namespace std;
+
+template <typename Queue>
+double timeQueries(Graph& g, const vector<pair<string, string>>& queries, long long& checksum) {
+    auto t0 = chrono::steady_clock::now();
+    for (const auto& q : queries) {
+        checksum += ShortestPath::find<Queue>(g, q.first, q.second).distance;
+    }
+    auto t1 = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(t1 - t0).count();
+}
+
+int main(int argc, char** argv) {
+    int cities = argc > 1 ? atoi(argv[1]) : 20000;
+    int routesPerCity = argc > 2 ? atoi(argv[2]) : 3;
+    int maxWeight = argc > 3 ? atoi(argv[3]) : 100;
+    bool skewed = argc > 4 && string(argv[4]) == "skewed";
+
+    mt19937 rng(42);
+    auto weight = [&]() {
+        if (!skewed) return 1 + (int)(rng() % maxWeight);
+        double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return 1 + (int)((maxWeight - 1) * u * u * u * u);
+    };
+
+    // Ring keeps the network connected; random chords add shortcuts
+    Graph g;
+    for (int i = 0; i < cities; ++i) {
+        g.addEdge("C" + to_string(i), "C" + to_string((i + 1) % cities), weight());
+        for (int r = 1; r < routesPerCity; ++r) {
+            g.addEdge("C" + to_string(i), "C" + to_string(rng() % cities), weight());
+        }
+    }
+    g.snapshot();
+
+    vector<pair<string, string>> queries;
+    for (int i = 0; i < 200; ++i) {
+        queries.push_back({"C" + to_string(rng() % cities), "C" + to_string(rng() % cities)});
+    }
+
+    cout << cities << " cities, ~" << routesPerCity << " routes/city, weights 1.." << maxWeight
+         << (skewed ? " (skewed)" : " (uniform)") << ", " << queries.size() << " queries\n";
+
+    long long checksum = 0;
+    struct Row { const char* name; double ms; };
+    Row rows[] = {
+        {"4-ary heap  ", timeQueries<FourAryHeap>(g, queries, checksum)},
+        {"radix heap  ", timeQueries<RadixHeap>(g, queries, checksum)},
+        {"Dial buckets", timeQueries<DialBuckets>(g, queries, checksum)},
+    };
+
+    const Row* best = &rows[0];
+    for (const Row& r : rows) {
+        cout << "  " << r.name << ": " << r.ms << " ms\n";
+        if (r.ms < best->ms) best = &r;
+    }
+    cout << "Fastest: " << best->name << " (checksum " << checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Checks that damaged snapshots are refused even with the checksum skipped.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -Icpp_src/include cpp_src/bench/SnapshotCheck.cpp
+//       $(ls cpp_src/src/*.cpp | grep -v main.cpp) -o snapshot_check -lpthread
+// Run:
+//   ./snapshot_check [directory=/tmp]
+//
+// Saves a small network, then for each case rewrites one section in a copy of
+// the file and opens it with verify_checksum off. Every copy must be rejected
+// (and none may crash or hang); the untouched file must still open and answer
+// queries. Exits non-zero on the first failure.
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <functional>
+#include "../include/PathFinder.h"
+
+using namespace std;
+
+// On-disk layout, as written by GraphSnapshot
+static const size_t SECTION_COUNT_AT = 32;
+static const size_t SECTION_TABLE_AT = 64;
+struct SectionEntry { uint32_t id, elemSize; uint64_t offset, count; };
+enum : uint32_t { NAME_OFFSETS = 2, INDEX_SLOTS = 6, CSR_OFFSETS = 7, CSR_TARGETS = 8,
+                  COMPONENTS = 12, LANDMARK_CITIES = 13, SPANNING_FOREST = 15 };
+
+static bool findSection(const string& file, uint32_t id, SectionEntry& out) {
+    uint32_t sections;
+    memcpy(&sections, file.data() + SECTION_COUNT_AT, sizeof sections);
+    for (uint32_t i = 0; i < sections; ++i) {
+        memcpy(&out, file.data() + SECTION_TABLE_AT + i * sizeof out, sizeof out);
+        if (out.id == id) return true;
+    }
+    return false;
+}
+
+template <typename T>
+static void put(string& file, size_t at, T value) {
+    memcpy(&file[at], &value, sizeof value);
+}
+
+int main(int argc, char** argv) {
+    string dir = argc > 1 ? argv[1] : "/tmp";
+    string good = dir + "/snapshot_check.snap", bad = dir + "/snapshot_check_bad.snap";
+
+    PathFinder pf;
+    for (int i = 0; i < 50; ++i) {
+        pf.addCity("C" + to_string(i), "C" + to_string((i + 1) % 50), 1 + i % 9);
+        pf.addCity("C" + to_string(i), "C" + to_string((i * 7 + 3) % 50 == i ? (i + 2) % 50 : (i * 7 + 3) % 50), 5);
+    }
+    OperationResult saved = pf.saveSnapshot(good);
+    if (!saved.success) {
+        cout << saved.message << "\n";
+        return 1;
+    }
+    ifstream in(good, ios::binary);
+    string file((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+    struct Case {
+        const char* name;
+        uint32_t section;
+        function<void(string&, const SectionEntry&)> corrupt;
+    };
+    vector<Case> cases = {
+        {"index slot id past the end", INDEX_SLOTS, [](string& f, const SectionEntry& s) {
+            for (size_t i = 0; i < s.count; ++i) put<uint32_t>(f, s.offset + i * s.elemSize + 8, 1u << 30);
+        }},
+        {"index slot table with no EMPTY slot", INDEX_SLOTS, [](string& f, const SectionEntry& s) {
+            for (size_t i = 0; i < s.count; ++i) put<uint32_t>(f, s.offset + i * s.elemSize + 8, 0);
+        }},
+        {"CSR offsets out of order", CSR_OFFSETS, [](string& f, const SectionEntry& s) {
+            put<uint32_t>(f, s.offset + 2 * s.elemSize, 1u << 30);
+        }},
+        {"CSR target past the end", CSR_TARGETS, [](string& f, const SectionEntry& s) {
+            put<uint32_t>(f, s.offset, 1u << 30);
+        }},
+        {"name offsets out of order", NAME_OFFSETS, [](string& f, const SectionEntry& s) {
+            put<uint64_t>(f, s.offset + 2 * s.elemSize, 1u << 30);
+        }},
+        {"component label past the end", COMPONENTS, [](string& f, const SectionEntry& s) {
+            put<uint32_t>(f, s.offset, 1u << 30);
+        }},
+        {"landmark city past the end", LANDMARK_CITIES, [](string& f, const SectionEntry& s) {
+            put<uint32_t>(f, s.offset, 1u << 30);
+        }},
+        {"spanning forest endpoint past the end", SPANNING_FOREST, [](string& f, const SectionEntry& s) {
+            put<uint32_t>(f, s.offset + 4, 1u << 30);
+        }},
+    };
+
+    int failures = 0;
+    for (const Case& c : cases) {
+        SectionEntry s;
+        if (!findSection(file, c.section, s) || s.count == 0) {
+            cout << c.name << ": section missing from the snapshot\n";
+            failures++;
+            continue;
+        }
+        string copy = file;
+        c.corrupt(copy, s);
+        ofstream(bad, ios::binary | ios::trunc) << copy;
+
+        PathFinder reader;
+        OperationResult r = reader.openSnapshot(bad, false);
+        cout << c.name << ": " << (r.success ? "ACCEPTED" : r.message) << "\n";
+        if (r.success) failures++;
+    }
+
+    PathFinder reader;
+    OperationResult r = reader.openSnapshot(good, false);
+    ShortestPathResult expected = pf.findShortestPath("C0", "C25");
+    ShortestPathResult got = reader.findShortestPath("C0", "C25");
+    bool unknownMissing = !reader.findShortestPath("Nowhere", "C1").found;
+    if (!r.success || got.distance != expected.distance || !got.found || !unknownMissing) {
+        cout << "Untouched snapshot did not reopen intact\n";
+        failures++;
+    }
+
+    remove(bad.c_str());
+    remove(good.c_str());
+    cout << (failures ? "FAILED" : "OK") << "\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include "MappedArray.h"
+
+using namespace std;
+
+// Dense city identifier handed out by Graph when a name is first seen
+typedef uint32_t CityId;
+const CityId NO_CITY = UINT32_MAX;
+
+struct Edge {
+    CityId dest;
+    int weight;
+};
+
+// --- Non-owning view over one city's routes inside a CSR snapshot ---
+// Iterating yields Edge values assembled from the parallel arrays, so walking
+// a hub city never allocates. Valid until the owning snapshot is rebuilt.
+class NeighborRange {
+    const CityId* targets;
+    const int* weights;
+    uint32_t count;
+public:
+    class iterator {
+        const CityId* t;
+        const int* w;
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef Edge value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const Edge* pointer;
+        typedef Edge reference;
+
+        iterator(const CityId* t, const int* w) : t(t), w(w) {}
+        Edge operator*() const { return {*t, *w}; }
+        iterator& operator++() { ++t; ++w; return *this; }
+        bool operator!=(const iterator& o) const { return t != o.t; }
+        bool operator==(const iterator& o) const { return t == o.t; }
+    };
+
+    NeighborRange() : targets(nullptr), weights(nullptr), count(0) {}
+    NeighborRange(const CityId* t, const int* w, uint32_t n) : targets(t), weights(w), count(n) {}
+
+    iterator begin() const { return iterator(targets, weights); }
+    iterator end() const { return iterator(targets + count, weights + count); }
+    uint32_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    Edge operator[](uint32_t i) const { return {targets[i], weights[i]}; }
+};
+
+// --- Compressed Sparse Row snapshot of the road network ---
+// Routes of city u live in targets/weights[offsets[u] .. offsets[u + 1]).
+// The snapshot is read-only; Graph rebuilds it after the network changes, or
+// borrows every array from a mapped snapshot file.
+struct CSRGraph {
+    MappedArray<uint32_t> offsets;
+    MappedArray<CityId> targets;
+    MappedArray<int> weights;
+    int maxWeight = 0;
+
+    // Optional coordinates in degrees (NaN when unknown). unitsPerKm is the
+    // smallest weight-per-great-circle-km over all located routes, so
+    // unitsPerKm * greatCircleKm(u, t) never overestimates the remaining cost.
+    MappedArray<double> latitude;
+    MappedArray<double> longitude;
+    bool fullyLocated = false;   // every city with routes has coordinates
+    double unitsPerKm = 0.0;
+
+    size_t numCities() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t numEdges() const { return targets.size(); }
+    uint32_t degree(CityId u) const { return offsets[u + 1] - offsets[u]; }
+    NeighborRange neighbors(CityId u) const {
+        return NeighborRange(targets.data() + offsets[u], weights.data() + offsets[u], degree(u));
+    }
+};
+
+#endif // CSR_GRAPH_H
@@ -13,9 +13,35 @@ struct MSTResult {
     string message;
 };
 
+enum class MSTAlgorithm {
+    Auto,           // Kruskal for small networks, Boruvka (or Filter-Kruskal on one core) for large
+    Kruskal,        // sort every route, then union-find
+    FilterKruskal,  // quicksort-style partitioning that drops heavy routes inside one tree early
+    Boruvka         // cheapest route out of every tree per round, scanned in parallel
+};
+
+// A route between two dense ids, each stored once with u < v
+struct MSTEdge {
+    int weight;
+    CityId u, v;
+};
+
 class CheapestNetwork {
 public:
-    static MSTResult find(Graph& g);
+    // Auto switches to the large-network algorithms from this many routes
+    static constexpr size_t LARGE_EDGE_COUNT = 1 << 17;
+
+    // Edges come back in ascending (weight, city id) order whichever algorithm runs
+    static MSTResult find(Graph& g, MSTAlgorithm algorithm = MSTAlgorithm::Auto);
+
+    // The forest itself as dense-id routes, in no particular order
+    static vector<MSTEdge> spanningForest(const CSRGraph& csr, MSTAlgorithm algorithm = MSTAlgorithm::Auto);
+    // Names, total cost and message for a forest over g, edges sorted
+    static MSTResult describe(Graph& g, vector<MSTEdge> tree);
+private:
+    static void kruskal(vector<MSTEdge>& edges, size_t numCities, vector<MSTEdge>& tree);
+    static void filterKruskal(vector<MSTEdge>& edges, size_t numCities, vector<MSTEdge>& tree);
+    static void boruvka(vector<MSTEdge>& edges, size_t numCities, vector<MSTEdge>& tree);
 };
 
 #endif // CHEAPEST_NETWORK_H
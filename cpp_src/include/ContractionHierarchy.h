@@ -0,0 +1,41 @@
+#ifndef CONTRACTION_HIERARCHY_H
+#define CONTRACTION_HIERARCHY_H
+
+#include "Graph.h"
+#include "ShortestPath.h"
+#include <string>
+#include <vector>
+
+// --- Contraction Hierarchies ---
+// Preprocesses a CSR snapshot by contracting cities in edge-difference order
+// and inserting shortcuts, so point-to-point queries only search "upward" in
+// the hierarchy from both ends. The engine is tied to the snapshot it was
+// built from; rebuild it after the network changes.
+class ContractionHierarchy {
+public:
+    ContractionHierarchy() {}
+    explicit ContractionHierarchy(const CSRGraph& csr) { build(csr); }
+
+    void build(const CSRGraph& csr);
+
+    // Same contract as ShortestPath::find; g must be unchanged since build()
+    ShortestPathResult query(Graph& g, string start, string end) const;
+
+    size_t numShortcuts() const { return shortcuts; }
+
+private:
+    // Upward edges: for city u, edges to higher-ranked cities in
+    // upTargets/upWeights/upMiddle[upOffsets[u] .. upOffsets[u + 1]).
+    // upMiddle is the contracted city a shortcut bypasses, NO_CITY for a route.
+    vector<uint32_t> rank;
+    vector<uint32_t> upOffsets;
+    vector<CityId> upTargets;
+    vector<int> upWeights;
+    vector<CityId> upMiddle;
+    size_t shortcuts = 0;
+
+    CityId middleOf(CityId a, CityId b) const;
+    void unpack(CityId from, CityId to, vector<CityId>& out) const;
+};
+
+#endif // CONTRACTION_HIERARCHY_H
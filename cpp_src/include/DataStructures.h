@@ -6,141 +6,237 @@
 #include <algorithm>
 #include <climits>
 #include <map>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include "MappedArray.h"
 
 using namespace std;
 
-// --- Custom Linked List based Stack for DFS & Reconstruct Path ---
+// --- Array based Stack for DFS & Reconstruct Path ---
+// Slots are kept after pop() and clear(), so a warm stack reuses them
+// (and any capacity they own) instead of allocating.
 template <typename T>
 class CustomStack {
 private:
-    struct Node { T data; Node* next; };
-    Node* topNode;
+    vector<T> slots;
+    size_t count;
 public:
-    CustomStack() : topNode(nullptr) {}
-    void push(T val) { topNode = new Node{val, topNode}; }
-    void pop() {
-        if (topNode) {
-            Node* t = topNode;
-            topNode = topNode->next;
-            delete t;
-        }
+    CustomStack() : count(0) {}
+    void reserve(size_t n) { slots.reserve(n); }
+    void push(const T& val) {
+        if (count < slots.size()) slots[count] = val;
+        else slots.push_back(val);
+        count++;
+    }
+    void push(T&& val) {
+        if (count < slots.size()) slots[count] = std::move(val);
+        else slots.push_back(std::move(val));
+        count++;
     }
-    T top() { return topNode->data; }
-    bool empty() { return topNode == nullptr; }
-    ~CustomStack() { while (!empty()) pop(); }
+    void pop() { if (count) count--; }
+    T& top() { return slots[count - 1]; }
+    const T& top() const { return slots[count - 1]; }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    void clear() { count = 0; }
 };
 
-// --- Custom Linked List based Queue for BFS ---
+// --- Ring buffer Queue for BFS ---
+// Power-of-two capacity that doubles when full; like CustomStack, dequeued
+// slots are reused rather than freed.
 template <typename T>
 class CustomQueue {
 private:
-    struct Node { T data; Node* next; };
-    Node *frontNode, *rearNode;
+    vector<T> slots;
+    size_t head, count;
+
+    void grow(size_t n) {
+        size_t cap = slots.empty() ? 16 : slots.size();
+        while (cap < n) cap *= 2;
+        if (cap == slots.size()) return;
+        vector<T> bigger(cap);
+        for (size_t i = 0; i < count; ++i) {
+            bigger[i] = std::move(slots[(head + i) & (slots.size() - 1)]);
+        }
+        slots.swap(bigger);
+        head = 0;
+    }
 public:
-    CustomQueue() : frontNode(nullptr), rearNode(nullptr) {}
-    void enqueue(T val) {
-        Node* newNode = new Node{val, nullptr};
-        if (!rearNode) { frontNode = rearNode = newNode; return; }
-        rearNode->next = newNode; rearNode = newNode;
+    CustomQueue() : head(0), count(0) {}
+    void reserve(size_t n) { grow(n); }
+    void enqueue(const T& val) {
+        if (count == slots.size()) grow(count + 1);
+        slots[(head + count++) & (slots.size() - 1)] = val;
+    }
+    void enqueue(T&& val) {
+        if (count == slots.size()) grow(count + 1);
+        slots[(head + count++) & (slots.size() - 1)] = std::move(val);
     }
     void dequeue() {
-        if (frontNode) {
-            Node* t = frontNode;
-            frontNode = frontNode->next;
-            if (!frontNode) rearNode = nullptr;
-            delete t;
+        if (count) {
+            head = (head + 1) & (slots.size() - 1);
+            count--;
         }
     }
-    T front() { return frontNode->data; }
-    bool empty() { return frontNode == nullptr; }
-    ~CustomQueue() { while (!empty()) dequeue(); }
+    T& front() { return slots[head]; }
+    const T& front() const { return slots[head]; }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    void clear() { head = count = 0; }
+};
+
+// --- Priority queue entry (see PriorityQueues.h for the queue policies)
+struct PQNode { int weight; uint32_t city; };
+
+// --- Packed string table ---
+// String i is bytes[offsets[i] .. offsets[i + 1]), so n names cost two
+// allocations in total and the table can be borrowed from a snapshot as-is.
+class StringTable {
+    MappedArray<uint64_t> offsets;   // empty, or one more than the string count
+    MappedArray<char> bytes;
+    friend class GraphSnapshot;
+
+public:
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    string_view operator[](size_t i) const {
+        return string_view(bytes.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    // Appends s with every byte passed through map
+    template <typename Map>
+    void push_back(string_view s, Map map) {
+        vector<uint64_t>& o = offsets.edit();
+        vector<char>& b = bytes.edit();
+        if (o.empty()) o.push_back(0);
+        for (char c : s) b.push_back(map(c));
+        o.push_back(b.size());
+    }
+    void push_back(string_view s) { push_back(s, [](char c) { return c; }); }
+
+    void reserve(size_t n) { offsets.edit().reserve(n + 1); }
+    void clear() { offsets.rebuild(); bytes.rebuild(); }
 };
 
-// --- Min-Priority Queue
-struct PQNode { int weight; string city; };
-
-class MinPQ {
-    vector<PQNode> heap;
-
-    // Helper: Move a node up to its correct position
-    void heapifyUp(int index) {
-        while (index > 0) {
-            int parent = (index - 1) / 2;
-            if (heap[index].weight < heap[parent].weight) {
-                swap(heap[index], heap[parent]);
-                index = parent;
-            } else {
-                break;
-            }
+// --- Case-insensitive city name index ---
+// Open-addressing hash table from city name to dense id. Each id keeps its
+// precomputed folded key; lookups fold the probe string on the fly, so a
+// string_view can be resolved in O(1) without allocating.
+class CityIndex {
+    // pad keeps the layout free of uninitialised bytes for snapshots
+    struct Slot { uint64_t hash; uint32_t id; uint32_t pad; };
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    MappedArray<Slot> slots;  // power-of-two sized, linear probing
+    StringTable folded;       // id -> folded key
+    size_t count = 0;
+    friend class GraphSnapshot;
+
+    static char fold(char c) { return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c; }
+
+    static uint64_t hashOf(string_view s) {
+        uint64_t h = 1469598103934665603ULL; // FNV-1a over folded bytes
+        for (char c : s) {
+            h ^= (unsigned char)fold(c);
+            h *= 1099511628211ULL;
         }
+        return h;
     }
 
-    // Helper: Move a node down to its correct position
-    void heapifyDown(int index) {
-        int size = heap.size();
-        while (true) {
-            int left = 2 * index + 1;
-            int right = 2 * index + 2;
-            int smallest = index;
-
-            if (left < size && heap[left].weight < heap[smallest].weight)
-                smallest = left;
-            if (right < size && heap[right].weight < heap[smallest].weight)
-                smallest = right;
-
-            if (smallest != index) {
-                swap(heap[index], heap[smallest]);
-                index = smallest;
-            } else {
-                break;
-            }
+    bool matches(const Slot& slot, uint64_t h, string_view s) const {
+        if (slot.hash != h) return false;
+        string_view key = folded[slot.id];
+        if (key.size() != s.size()) return false;
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (key[i] != fold(s[i])) return false;
+        }
+        return true;
+    }
+
+    void grow() {
+        vector<Slot> old;
+        old.swap(slots.edit());
+        vector<Slot>& table = slots.rebuild();
+        table.assign(old.empty() ? 16 : old.size() * 2, {0, EMPTY, 0});
+        size_t mask = table.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.id == EMPTY) continue;
+            size_t i = slot.hash & mask;
+            while (table[i].id != EMPTY) i = (i + 1) & mask;
+            table[i] = slot;
         }
     }
 
 public:
-    void push(int w, string c) {
-        heap.push_back({w, c});
-        heapifyUp(heap.size() - 1);
-    }
-
-    PQNode pop() {
-        if (heap.empty()) return {0, ""}; // Safety check
-        
-        PQNode top = heap[0];
-        heap[0] = heap.back();
-        heap.pop_back();
-        
-        if (!heap.empty()) {
-            heapifyDown(0);
+    // Returns the id stored for name, or UINT32_MAX
+    uint32_t find(string_view name) const {
+        if (slots.empty()) return EMPTY;
+        uint64_t h = hashOf(name);
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask; slots[i].id != EMPTY; i = (i + 1) & mask) {
+            if (matches(slots[i], h, name)) return slots[i].id;
         }
-        return top;
+        return EMPTY;
+    }
+
+    // Maps name to id unless a case variant is already present; returns the stored id
+    uint32_t insert(string_view name, uint32_t id) {
+        uint32_t existing = find(name);
+        if (existing != EMPTY) return existing;
+
+        if ((count + 1) * 4 > slots.size() * 3) grow();
+        // Ids are handed out in order, so id is always the next key
+        folded.push_back(name, fold);
+
+        uint64_t h = hashOf(name);
+        vector<Slot>& table = slots.edit();
+        size_t mask = table.size() - 1;
+        size_t i = h & mask;
+        while (table[i].id != EMPTY) i = (i + 1) & mask;
+        table[i] = {h, id, 0};
+        count++;
+        return id;
     }
 
-    bool empty() { return heap.empty(); }
+    // Sizes the table for `n` names so a bulk insert never rehashes
+    void reserve(size_t n) {
+        folded.reserve(n);
+        while (n * 4 > slots.size() * 3) grow();
+    }
+
+    size_t size() const { return count; }
+    void clear() { slots.rebuild(); folded.clear(); count = 0; }
 };
 
-// --- Disjoint Set for MST (Kruskal's) ---
+// --- Disjoint Set for MST (Kruskal's / Boruvka's) ---
+// Array-based union-find over dense city ids: union by size, iterative find
+// with path halving.
 class DisjointSet {
-    map<string, string> parent;
-    map<string, int> rank;
+    vector<uint32_t> parent;
+    vector<uint32_t> setSize;
 public:
-    void makeSet(string s) {
-        parent[s] = s;
-        rank[s] = 0;
-    }
-    string find(string s) {
-        if (parent.find(s) == parent.end()) makeSet(s);
-        if (parent[s] != s) parent[s] = find(parent[s]);
-        return parent[s];
-    }
-    void unite(string x, string y) {
-        string rootX = find(x);
-        string rootY = find(y);
-        if (rootX != rootY) {
-            if (rank[rootX] < rank[rootY]) swap(rootX, rootY);
-            parent[rootY] = rootX;
-            if (rank[rootX] == rank[rootY]) rank[rootX]++;
+    explicit DisjointSet(size_t n = 0) { reset(n); }
+    void reset(size_t n) {
+        parent.resize(n);
+        for (size_t i = 0; i < n; ++i) parent[i] = i;
+        setSize.assign(n, 1);
+    }
+    uint32_t find(uint32_t x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
         }
+        return x;
+    }
+    // Returns false if x and y were already in the same set
+    bool unite(uint32_t x, uint32_t y) {
+        x = find(x);
+        y = find(y);
+        if (x == y) return false;
+        if (setSize[x] < setSize[y]) swap(x, y);
+        parent[y] = x;
+        setSize[x] += setSize[y];
+        return true;
     }
 };
 
@@ -0,0 +1,49 @@
+#ifndef DYNAMIC_MST_H
+#define DYNAMIC_MST_H
+
+#include "CheapestNetwork.h"
+#include <vector>
+
+// --- Incrementally maintained minimum spanning forest ---
+// Follows the route edits PathFinder makes to its Graph. A new or cheaper
+// route replaces the heaviest forest route on the cycle it closes; removing a
+// forest route (or making it dearer) searches the smaller half for the
+// cheapest route that reconnects the two halves. Each edit costs time
+// proportional to the affected tree instead of a full Kruskal.
+class DynamicMST {
+public:
+    bool built() const { return isBuilt; }
+    void clear();
+
+    // Full Kruskal over g's current routes
+    void build(Graph& g);
+    // Adopts a forest saved from this same network, skipping Kruskal
+    void build(Graph& g, const MappedArray<MSTEdge>& saved);
+
+    // Call after g has been edited; ids are the route's two cities
+    void onRouteSet(Graph& g, CityId u, CityId v, int weight);
+    void onRouteRemoved(Graph& g, CityId u, CityId v);
+
+    MSTResult result(Graph& g);
+    // Forest routes, each once with u < v
+    vector<MSTEdge> edges() const;
+
+private:
+    bool isBuilt = false;
+    vector<vector<Edge>> forest;   // id -> forest routes at that city
+
+    // BFS scratch: mark[c] == stamp (or stamp + 1) tags the side a city was reached from
+    vector<uint32_t> mark;
+    vector<CityId> parent;
+    vector<int> parentWeight;
+    uint32_t stamp = 0;
+
+    void grow(size_t ids);
+    uint32_t nextStamp();
+    int forestWeight(CityId u, CityId v) const;   // -1 if (u, v) is not a forest route
+    void link(CityId u, CityId v, int weight);
+    void cut(CityId u, CityId v);
+    void reconnect(Graph& g, CityId u, CityId v);
+};
+
+#endif // DYNAMIC_MST_H
@@ -0,0 +1,45 @@
+#ifndef DYNAMIC_SPT_H
+#define DYNAMIC_SPT_H
+
+#include "ShortestPath.h"
+#include <vector>
+
+// --- Shortest-path trees for a set of hot sources, repaired across route edits ---
+// Follows the route edits PathFinder makes to its Graph. A cheaper or new
+// route pushes the improvement outward with a Dijkstra that stops where
+// distances no longer drop. A dearer or removed tree route invalidates the
+// subtree below it, which is re-settled from its boundary with the rest of the
+// tree (Ramalingam-Reps). Routes outside the tree that get dearer cost nothing.
+class DynamicSPT {
+public:
+    // Builds one tree per distinct id, replacing any previous set
+    void setSources(Graph& g, const vector<CityId>& sources);
+    const vector<CityId>& sources() const { return roots; }
+    void clear();
+
+    // Call after g has been edited; ids are the route's two cities
+    void onRouteSet(Graph& g, CityId u, CityId v, int weight);
+    void onRouteRemoved(Graph& g, CityId u, CityId v);
+
+    // Answers s -> t from the tree of s or t in O(path length); false if
+    // neither is a hot source. Read-only, so safe alongside other queries.
+    bool query(Graph& g, CityId s, CityId t, ShortestPathResult& res) const;
+
+private:
+    vector<CityId> roots;
+    vector<ShortestPathTree> trees;   // parallel to roots
+
+    // Repair scratch: inSubtree[c] == stamp marks the invalidated subtree
+    vector<uint32_t> inSubtree;
+    uint32_t stamp = 0;
+    vector<CityId> subtree;
+    FourAryHeap pq;
+
+    void grow(ShortestPathTree& tree, size_t ids);
+    uint32_t nextStamp();
+    void improve(Graph& g, ShortestPathTree& tree, CityId from, CityId to, int weight);
+    void lengthen(Graph& g, ShortestPathTree& tree, CityId child);
+    void settle(Graph& g, ShortestPathTree& tree);
+};
+
+#endif // DYNAMIC_SPT_H
@@ -2,6 +2,7 @@
 #define FEWEST_STOPS_H
 
 #include "Graph.h"
+#include "SearchWorkspace.h"
 #include <string>
 #include <vector>
 
@@ -15,6 +16,20 @@ struct FewestStopsResult {
 class FewestStops {
 public:
     static FewestStopsResult find(Graph& g, string start, string end);
+
+    // Direction-optimizing BFS from every id in `sources` at once. Each level is
+    // expanded top-down from the frontier list, or bottom-up by letting the
+    // unvisited cities look for a parent in the frontier bitmap once the
+    // frontier's routes outnumber the unexplored ones; large levels are split
+    // across threads. hops[c] is -1 for unreached cities; `parents` (optional)
+    // receives the BFS tree. Stops after the level that reaches `stopAt`.
+    static void bfs(const CSRGraph& csr, const vector<CityId>& sources, vector<int>& hops,
+                    vector<CityId>* parents = nullptr, CityId stopAt = NO_CITY);
+
+private:
+    // bfs() on a workspace; touches only the cities it reaches until it goes bottom-up
+    static void explore(const CSRGraph& csr, const vector<CityId>& sources,
+                        SearchWorkspace& ws, CityId stopAt);
 };
 
 #endif // FEWEST_STOPS_H
@@ -4,30 +4,105 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <cmath>
 #include "DataStructures.h"
+#include "CSRGraph.h"
 
-struct Edge {
-    string dest;
-    int weight;
-};
+// Haversine distance in kilometres between two points given in degrees
+inline double greatCircleKm(double lat1, double lon1, double lat2, double lon2) {
+    const double R = 6371.0088, RAD = M_PI / 180.0;
+    double dLat = (lat2 - lat1) * RAD, dLon = (lon2 - lon1) * RAD;
+    double a = sin(dLat / 2) * sin(dLat / 2) +
+               cos(lat1 * RAD) * cos(lat2 * RAD) * sin(dLon / 2) * sin(dLon / 2);
+    return 2 * R * asin(sqrt(a < 1.0 ? a : 1.0));
+}
 
 class Graph {
 private:
-    map<string, vector<Edge>> adjList;
-    map<string, string> lowerToOriginal; // lowercase -> original case
+    StringTable names;               // id -> original case name
+    CityIndex index;                 // case-folded name -> id
+    vector<vector<Edge>> adjList;    // id -> routes (empty once a city loses its last route)
+    MappedArray<double> latitude;    // id -> degrees, NaN when unknown
+    MappedArray<double> longitude;
+    int cityCount = 0;
+    uint64_t version = 0;            // bumped by every edit
+
+    CSRGraph csr;
+    bool csrDirty = true;
+    // Opened from a snapshot: routes are read straight from csr and adjList
+    // is only built by the first edit
+    bool mapped = false;
+
+    // Connected components: comp[id] labels a component by one of its members
+    // and members[label] lists them. Route additions merge small into large;
+    // removals only flag the component, which is re-split on its next query.
+    vector<CityId> comp;
+    vector<vector<CityId>> members;
+    vector<char> compDirty;
+
+    CityId intern(string_view name);
+    void mergeComponents(CityId u, CityId v);
+    void splitComponent(CityId label);
+    CityId componentOf(CityId id);
+    void eraseHalf(CityId from, CityId to);
+    void touch() { csrDirty = true; version++; }
+    void materialize();
+    uint32_t degreeOf(CityId id) const { return mapped ? csr.degree(id) : adjList[id].size(); }
+    template <typename F>
+    void forEachRoute(CityId id, F f) const {
+        if (mapped) {
+            for (const Edge& e : csr.neighbors(id)) f(e);
+        } else {
+            for (const Edge& e : adjList[id]) f(e);
+        }
+    }
+
+    friend class GraphSnapshot;
 
 public:
     void addEdge(string u, string v, int w);
     bool updateEdge(string u, string v, int w);
     void removeEdge(string u, string v);
-    bool hasEdge(string u, string v);
-    vector<Edge> getNeighbors(string u);
+    bool hasEdge(string u, string v) const;
+    // Adds the route sources[i] <-> destinations[i] (weights[i]) for every i in
+    // one pass: names are interned once, duplicates within the batch keep their
+    // last weight and a route already in the graph is overwritten, as addEdge
+    // would. Rows naming the same city twice are skipped. Every adjacency list
+    // is sized once. Returns the number of distinct routes written.
+    size_t bulkLoad(const vector<string>& sources, const vector<string>& destinations,
+                    const vector<int>& weights);
+    // Zero-copy view of u's routes; invalidated by the next edit
+    NeighborRange getNeighbors(const string& u);
     vector<string> getNodes();
     void clear();
     int getCityCount();
+    // Changes whenever routes or coordinates change; lets callers cache derived data
+    uint64_t getVersion() const { return version; }
     // Helper to get all edges for MST
     vector<tuple<int, string, string>> getAllEdges();
+
+    // Attach coordinates (degrees) to a city, creating its name entry if needed
+    void setLocation(string_view city, double lat, double lon);
+
+    // Dense id access for the algorithms; NO_CITY if the city has no routes
+    CityId findCity(string_view name) const;
+    string_view getName(CityId id) const { return names[id]; }
+    // Ids handed out so far, including cities that have since lost all routes
+    size_t idCount() const { return names.size(); }
+    // Live routes of a city; unlike snapshot() this never triggers a rebuild.
+    // On a graph opened from a snapshot, only valid after its first edit.
+    const vector<Edge>& routesOf(CityId id) const { return adjList[id]; }
+    // O(1) unless a route removal left the component waiting to be re-split
+    bool connected(CityId a, CityId b) { return componentOf(a) == componentOf(b); }
+    // Every city in id's component, id included
+    const vector<CityId>& componentMembers(CityId id) { return members[componentOf(id)]; }
+    // Read-only CSR view of the current network, rebuilt lazily after edits
+    const CSRGraph& snapshot();
+    // Builds everything snapshot() and connected() would build lazily, so the
+    // graph can be read from many threads as long as nobody edits it
+    void freeze();
 };
 
 #endif // GRAPH_H
@@ -0,0 +1,35 @@
+#ifndef GRAPH_SNAPSHOT_H
+#define GRAPH_SNAPSHOT_H
+
+#include "Graph.h"
+#include "Landmarks.h"
+#include "CheapestNetwork.h"
+#include "MappedArray.h"
+#include <string>
+#include <vector>
+
+// --- Versioned, checksummed binary snapshot of a network ---
+// Layout: a 64-byte header, a table of sections, then each section's raw
+// little-endian array at a 64-byte aligned offset. The name table, name
+// index, CSR adjacency, coordinates, component labels, ALT landmark tables
+// and spanning forest are all stored in exactly the form Graph keeps them,
+// so read() mmaps the file and lends the arrays out without copying; it
+// only range-checks the stored ids and rebuilds the component member lists.
+// The pages stay shared between every process that opens the same file.
+class GraphSnapshot {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+
+    // Writes to path + ".tmp" and renames it over path, so processes that
+    // already mapped an older file keep reading it intact
+    static bool write(const string& path, Graph& g, const Landmarks& landmarks,
+                      const vector<MSTEdge>& forest, string& error);
+
+    // Replaces g, landmarks and forest with views into the mapped file. The
+    // header, section bounds and every stored offset and city id are always
+    // checked; verifyChecksum also hashes the whole file.
+    static bool read(const string& path, bool verifyChecksum, Graph& g, Landmarks& landmarks,
+                     MappedArray<MSTEdge>& forest, string& error);
+};
+
+#endif // GRAPH_SNAPSHOT_H
@@ -0,0 +1,44 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "CSRGraph.h"
+#include "MappedArray.h"
+#include <vector>
+#include <climits>
+
+// --- ALT landmark tables ---
+// Picks k landmarks by farthest selection and stores the exact distance from
+// each landmark to every city. By the triangle inequality
+//   |d(L, t) - d(L, v)| <= d(v, t)
+// for every landmark L, which gives A* a consistent potential without
+// coordinates. Memory is k x V ints, laid out city-major so one bound reads
+// a single contiguous row.
+class Landmarks {
+public:
+    void build(const CSRGraph& csr, int k);
+    void clear() { tables.rebuild(); landmarks.clear(); }
+
+    bool empty() const { return landmarks.empty(); }
+    int count() const { return landmarks.size(); }
+    const vector<CityId>& cities() const { return landmarks; }
+
+    // Lower bound on the distance between v and t
+    int lowerBound(CityId v, CityId t) const {
+        const int* dv = &tables[(size_t)v * landmarks.size()];
+        const int* dt = &tables[(size_t)t * landmarks.size()];
+        int best = 0;
+        for (size_t i = 0; i < landmarks.size(); ++i) {
+            if (dv[i] == INT_MAX || dt[i] == INT_MAX) continue;
+            int diff = dv[i] > dt[i] ? dv[i] - dt[i] : dt[i] - dv[i];
+            if (diff > best) best = diff;
+        }
+        return best;
+    }
+
+private:
+    vector<CityId> landmarks;
+    MappedArray<int> tables;   // tables[v * k + i] = d(landmark i, v), INT_MAX if unreachable
+    friend class GraphSnapshot;
+};
+
+#endif // LANDMARKS_H
@@ -10,15 +10,24 @@ struct LongestPathResult {
     vector<string> path;
     int distance;
     string message;
+    bool provenLongest;   // false when the budget ran out first; path is the best found
 };
 
 class LongestPath {
 public:
-    static LongestPathResult find(Graph& g, string start, string end);
+    // Components up to this size are solved exactly by bitmask DP (2^n * n ints)
+    static constexpr int DP_MAX_CITIES = 18;
+    static constexpr int DEFAULT_TIME_BUDGET_MS = 1000;
+
+    // Longest simple path. Larger components are searched by branch and bound
+    // split across threads, seeded with the shortest path, which stops after
+    // `timeBudgetMs` or `nodeBudget` search nodes (0 = no node limit) and keeps
+    // the best path found so far.
+    static LongestPathResult find(Graph& g, string start, string end,
+                                  int timeBudgetMs = DEFAULT_TIME_BUDGET_MS, long nodeBudget = 0);
 private:
-    static void dfsLongest(Graph& g, string current, string end, 
-                          map<string, bool>& visited, vector<string>& currentPath,
-                          int currentDist, vector<string>& bestPath, int& maxDist);
+    static void bitmaskDP(const CSRGraph& csr, const vector<CityId>& component,
+                          CityId start, CityId end, vector<CityId>& bestPath, int& maxDist);
 };
 
 #endif // LONGEST_PATH_H
@@ -0,0 +1,61 @@
+#ifndef MAPPED_ARRAY_H
+#define MAPPED_ARRAY_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+using namespace std;
+
+// --- Array that owns its elements or borrows them from a mapped snapshot ---
+// Reads look the same either way. A borrowed array keeps its mapping alive
+// through `mapping`, so copies of it share the file pages instead of memory.
+// edit() hands out the owned vector, copying borrowed elements in first;
+// rebuild() hands it out empty for callers about to overwrite everything.
+template <typename T>
+class MappedArray {
+    vector<T> own;
+    const T* borrowedData = nullptr;
+    size_t borrowedSize = 0;
+    shared_ptr<const void> mapping;   // set while borrowing
+
+public:
+    MappedArray() = default;
+    MappedArray(const vector<T>& v) : own(v) {}
+    MappedArray& operator=(const vector<T>& v) {
+        mapping.reset();
+        own = v;
+        return *this;
+    }
+
+    bool borrowed() const { return mapping != nullptr; }
+    const T* data() const { return mapping ? borrowedData : own.data(); }
+    size_t size() const { return mapping ? borrowedSize : own.size(); }
+    bool empty() const { return size() == 0; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+
+    vector<T>& edit() {
+        if (mapping) {
+            own.assign(borrowedData, borrowedData + borrowedSize);
+            mapping.reset();
+        }
+        return own;
+    }
+    vector<T>& rebuild() {
+        mapping.reset();
+        own.clear();
+        return own;
+    }
+
+    // Points at n elements inside `owner`'s memory, dropping any owned ones
+    void borrow(shared_ptr<const void> owner, const T* p, size_t n) {
+        vector<T>().swap(own);
+        mapping = move(owner);
+        borrowedData = p;
+        borrowedSize = n;
+    }
+};
+
+#endif // MAPPED_ARRAY_H
@@ -10,15 +10,24 @@ struct TourResult {
     vector<string> path;
     int totalDistance;
     string message;
+    bool provenOptimal;   // false when the time budget ran out before the search finished
 };
 
 class MultiCityTour {
 public:
-    static TourResult plan(Graph& g, vector<string> cities);
+    // Held-Karp needs 2^(n-1) * (n-1) ints, so the exact planner stops here
+    static constexpr int MAX_STOPS = 20;
+    static constexpr int DEFAULT_TIME_BUDGET_MS = 1000;
+
+    // Up to MAX_STOPS the tour is exact. Larger tours get a local-search tour that
+    // branch and bound then tries to prove or improve; `timeBudgetMs` covers the
+    // distance table, the local search and branch and bound, and the best tour
+    // found is returned when it expires. A budget that runs out while the table
+    // is still being built falls back to a nearest-neighbour walk over the graph.
+    static TourResult plan(Graph& g, vector<string> cities,
+                           int timeBudgetMs = DEFAULT_TIME_BUDGET_MS);
 private:
-    static void tspHelper(Graph& g, vector<string>& cities, vector<bool>& visited, 
-                         string current, int count, int cost, int& minCost, 
-                         vector<string>& currentPath, vector<string>& bestPath);
+    static vector<int> heldKarp(const vector<int>& dist, int n);
 };
 
 #endif // MULTI_CITY_TOUR_H
@@ -7,40 +7,180 @@
 #include "ReachableCities.h"
 #include "MultiCityTour.h"
 #include "CheapestNetwork.h"
+#include "DynamicMST.h"
+#include "DynamicSPT.h"
 #include "LongestPath.h"
+#include "ContractionHierarchy.h"
+#include "QueryCache.h"
+#include "GraphSnapshot.h"
+#include "WorkerPool.h"
 #include <string>
 #include <vector>
 #include <tuple>
+#include <optional>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+// (latitude, longitude) in degrees
+typedef pair<double, double> LatLon;
 
 struct OperationResult {
     bool success;
     string message;
 };
 
+// Query kinds accepted by PathFinder::batchQuery
+enum class QueryKind {
+    ShortestPath,
+    FewestStops,
+    LongestPath
+};
+
+struct BatchResult {
+    bool found;
+    vector<string> path;
+    int distance;   // stops for FewestStops
+    string message;
+};
+
+// One published state of the network. Writers edit a private copy and publish
+// it whole; readers pin whichever version is current and it never changes
+// under them. Tables derived from the graph alone are built by the first
+// query that needs them and shared by every reader of the version.
+struct NetworkVersion {
+    uint64_t seq = 0;   // publication order
+    Graph graph;        // frozen before publication
+
+    // Carried into the next version and kept up to date by writers once a reader has built it
+    DynamicMST mst;
+    atomic<bool> mstReady{false};
+    once_flag mstOnce;
+    MappedArray<MSTEdge> savedForest;   // from an opened snapshot; seeds mst without Kruskal
+
+    // Shortest-path trees of the hot sources, repaired by every route edit
+    DynamicSPT hotTrees;
+
+    int landmarkCount = 16;
+    once_flag landmarkOnce;
+    Landmarks landmarks;
+
+    once_flag chOnce;
+    unique_ptr<ContractionHierarchy> ch;
+};
+
+// Safe to share between threads: queries run concurrently against the version
+// they pinned, while edits are serialised into a private pending version that
+// the next query publishes, so a run of edits costs one copy of the network.
+// A version is freed once the last query holding it returns.
 class PathFinder {
 private:
-    Graph graph;
+    // Read and replaced only through atomic_load / atomic_store
+    shared_ptr<NetworkVersion> current;
+    mutex writeLock;
+    shared_ptr<NetworkVersion> pending;   // guarded by writeLock
+    atomic<bool> hasPending{false};
+
+    // Query results keyed by kind and endpoints, dropped whenever a new
+    // version is published. Trees (off by default) answer any query from a
+    // cached source or target without searching.
+    mutex cacheLock;
+    LRUCache<QueryKey, ShortestPathResult, QueryKeyHash> pathCache{DEFAULT_CACHE_CAPACITY};
+    LRUCache<QueryKey, FewestStopsResult, QueryKeyHash> stopsCache{DEFAULT_CACHE_CAPACITY};
+    LRUCache<CityId, ShortestPathTree> treeCache{0};
+    uint64_t cacheVersion = 0;
+    atomic<long> cacheHits{0}, cacheTreeHits{0}, cacheMisses{0};
+    atomic<bool> caching{true};   // false once both limits are 0; queries then skip cacheLock
+
+    // Threads that answer batchQuery, started by the first batch
+    WorkerPool workers;
+
+    // The current version, after publishing any pending edits
+    shared_ptr<NetworkVersion> pin();
+    // With writeLock held: the version writers edit, copied from current on the first edit
+    NetworkVersion& edit();
+    // With writeLock held: pending if there is one, else current
+    const NetworkVersion& latest() const { return pending ? *pending : *current; }
+
+    // With cacheLock held: true if the caches belong to version `seq`
+    // (clearing them when it is newer), false for a reader of an older version
+    bool syncCache(uint64_t seq);
+    // Runs the requested search without consulting the cache
+    ShortestPathResult search(NetworkVersion& v, string start, string end, SearchMode mode);
 
 public:
-    PathFinder() {}
+    static const int DEFAULT_CACHE_CAPACITY = 1024;
+
+    PathFinder();
 
     // Graph operations
-    OperationResult addCity(string city1, string city2, int distance);
+    OperationResult addCity(string city1, string city2, int distance,
+                            optional<LatLon> location1 = nullopt,
+                            optional<LatLon> location2 = nullopt);
+    OperationResult setCityLocation(string city, double latitude, double longitude);
     OperationResult updateCity(string city1, string city2, int distance);
     OperationResult removeCity(string city1, string city2);
+    // Adds sources[i] <-> destinations[i] (distances[i]) for every i in one linear
+    // pass; later duplicates win. Rejects the whole batch if the arrays differ in
+    // length or any row has a non-positive distance or the same city twice.
+    OperationResult loadEdges(const vector<string>& sources, const vector<string>& destinations,
+                              const vector<int>& distances);
     
     // Query operations
-    ShortestPathResult findShortestPath(string start, string end);
-    LongestPathResult findLongestPath(string start, string end);
+    ShortestPathResult findShortestPath(string start, string end,
+                                        SearchMode mode = SearchMode::Dijkstra);
+    // Runs Contraction Hierarchies preprocessing now instead of on the first CH query
+    void prepareContractionHierarchy();
+    // Number of ALT landmarks (memory is k x cities ints); takes effect on the next ALT query
+    OperationResult setLandmarkCount(int k);
+    void prepareLandmarks();
+    // One early-stopping Dijkstra per source; rows follow `sources`, columns `targets`
+    DistanceMatrix distanceMatrix(vector<string> sources, vector<string> targets);
+    LongestPathResult findLongestPath(string start, string end,
+                                      int timeBudgetMs = LongestPath::DEFAULT_TIME_BUDGET_MS,
+                                      long nodeBudget = 0);
     FewestStopsResult findFewestStops(string start, string end);
+    // Fewest stops from the nearest of `sources` to every reachable city, sorted
+    // by hops then name; unknown sources are ignored
+    vector<pair<string, int>> hopCounts(vector<string> sources);
     vector<string> findReachableCities(string start);
-    TourResult planMultiCityTour(vector<string> cities);
-    MSTResult findCheapestNetwork();
+    // Runs every (kind, start, end) request across the worker pool; results
+    // follow the order of `requests`, and a request that throws comes back
+    // unfound with the error as its message
+    vector<BatchResult> batchQuery(vector<tuple<QueryKind, string, string>> requests,
+                                   SearchMode mode = SearchMode::Dijkstra);
+    TourResult planMultiCityTour(vector<string> cities,
+                                 int timeBudgetMs = MultiCityTour::DEFAULT_TIME_BUDGET_MS);
+    // Auto reads the maintained forest; any other algorithm recomputes from scratch
+    MSTResult findCheapestNetwork(MSTAlgorithm algorithm = MSTAlgorithm::Auto);
     
     // Get graph data
     vector<string> getAllCities();
     vector<tuple<string, string, int>> getAllRoutes();
     void clearAll();
+
+    // Keeps a shortest-path tree for each of `cities` up to date across edits, so
+    // shortest-path queries from or to them are answered without searching.
+    // Replaces the previous set; an empty list drops them all.
+    OperationResult setHotSources(vector<string> cities);
+    vector<string> getHotSources();
+
+    // Writes the current network with its component labels, landmark tables and
+    // spanning forest (building them first if needed) to a binary snapshot
+    OperationResult saveSnapshot(string path);
+    // Replaces the network with one mapped from a snapshot file: queries read
+    // it in place, and the first edit copies the graph out of the mapping.
+    // Hot sources and contraction hierarchies are not stored and start empty.
+    OperationResult openSnapshot(string path, bool verifyChecksum = true);
+
+    // Result cache limits in entries; 0 disables. Each cached tree holds two
+    // ints per city.
+    OperationResult setCacheCapacity(int entries);
+    OperationResult setTreeCacheCapacity(int trees);
+    CacheStats getCacheStats();
+    // Drops every cached result and resets the counters
+    void clearCache();
 };
 
 #endif // PATH_FINDER_H
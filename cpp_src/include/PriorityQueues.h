@@ -0,0 +1,174 @@
+#ifndef PRIORITY_QUEUES_H
+#define PRIORITY_QUEUES_H
+
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include "DataStructures.h"
+
+using namespace std;
+
+// Queue policies for ShortestPath. Every policy offers the same interface:
+//   reset(numCities, maxWeight)  prepare for a new search
+//   push(city, key)              insert, or lower the key of a queued city
+//   pop()                        remove the minimum as {key, city}
+//   empty()
+// Keys are non-negative tentative distances and never go below the last
+// popped key, which is what the radix heap and Dial buckets rely on.
+// Policies may hand back stale entries; Dijkstra skips those against dist[].
+
+// --- Indexed D-ary heap with true decrease-key ---
+// Entries carry their key inline so sifting never chases the position array.
+template <int D>
+class IndexedDaryHeap {
+    static constexpr uint32_t ABSENT = UINT32_MAX;
+
+    vector<PQNode> heap;    // {key, city}
+    vector<uint32_t> pos;   // city -> index in heap, ABSENT when not queued
+
+    void siftUp(uint32_t i, PQNode node) {
+        while (i > 0) {
+            uint32_t parent = (i - 1) / D;
+            if (heap[parent].weight <= node.weight) break;
+            heap[i] = heap[parent];
+            pos[heap[i].city] = i;
+            i = parent;
+        }
+        heap[i] = node;
+        pos[node.city] = i;
+    }
+
+    void siftDown(uint32_t i, PQNode node) {
+        uint32_t size = heap.size();
+        while (true) {
+            uint32_t first = i * D + 1;
+            if (first >= size) break;
+            uint32_t last = first + D < size ? first + D : size;
+            uint32_t best = first;
+            for (uint32_t c = first + 1; c < last; ++c) {
+                if (heap[c].weight < heap[best].weight) best = c;
+            }
+            if (heap[best].weight >= node.weight) break;
+            heap[i] = heap[best];
+            pos[heap[i].city] = i;
+            i = best;
+        }
+        heap[i] = node;
+        pos[node.city] = i;
+    }
+
+public:
+    void reset(size_t numCities, int /*maxWeight*/) {
+        // Only cities still queued from the last search carry a position
+        for (const PQNode& n : heap) pos[n.city] = ABSENT;
+        heap.clear();
+        if (pos.size() < numCities) pos.resize(numCities, ABSENT);
+    }
+
+    void push(uint32_t city, int k) {
+        uint32_t i = pos[city];
+        if (i == ABSENT) {
+            heap.push_back({k, city});
+            siftUp(heap.size() - 1, {k, city});
+        } else if (k < heap[i].weight) {
+            siftUp(i, {k, city});
+        }
+    }
+
+    PQNode pop() {
+        PQNode top = heap[0];
+        pos[top.city] = ABSENT;
+        PQNode last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) siftDown(0, last);
+        return top;
+    }
+
+    PQNode top() const { return heap[0]; }
+    bool empty() const { return heap.empty(); }
+};
+
+// --- Monotone radix heap ---
+// Bucket b holds keys whose highest bit differing from the last popped key
+// is b - 1. Each entry moves to a lower bucket at most 32 times.
+class RadixHeap {
+    static constexpr int BUCKETS = 33;
+
+    vector<PQNode> buckets[BUCKETS];
+    int last = 0;
+    size_t count = 0;
+
+    static int bucketOf(int k, int last) {
+        unsigned diff = (unsigned)k ^ (unsigned)last;
+        return diff == 0 ? 0 : 32 - __builtin_clz(diff);
+    }
+
+public:
+    void reset(size_t /*numCities*/, int /*maxWeight*/) {
+        for (auto& b : buckets) b.clear();
+        last = 0;
+        count = 0;
+    }
+
+    void push(uint32_t city, int k) {
+        buckets[bucketOf(k, last)].push_back({k, city});
+        count++;
+    }
+
+    PQNode pop() {
+        if (buckets[0].empty()) {
+            int b = 1;
+            while (buckets[b].empty()) b++;
+
+            int minKey = INT_MAX;
+            for (const PQNode& n : buckets[b]) minKey = n.weight < minKey ? n.weight : minKey;
+            last = minKey;
+            for (const PQNode& n : buckets[b]) buckets[bucketOf(n.weight, last)].push_back(n);
+            buckets[b].clear();
+        }
+        PQNode top = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return top;
+    }
+
+    bool empty() const { return count == 0; }
+};
+
+// --- Dial's bucket queue ---
+// Circular array of maxWeight + 1 buckets; every queued key lies within
+// maxWeight of the current minimum, so bucket key % size is unambiguous.
+// Best suited to small integer weights.
+class DialBuckets {
+    vector<vector<PQNode>> buckets;
+    size_t cursor = 0;
+    size_t count = 0;
+
+public:
+    void reset(size_t /*numCities*/, int maxWeight) {
+        size_t size = (size_t)maxWeight + 1;
+        if (buckets.size() != size) buckets.assign(size, {});
+        else for (auto& b : buckets) b.clear();
+        cursor = 0;
+        count = 0;
+    }
+
+    void push(uint32_t city, int k) {
+        buckets[(size_t)k % buckets.size()].push_back({k, city});
+        count++;
+    }
+
+    PQNode pop() {
+        while (buckets[cursor].empty()) cursor = (cursor + 1) % buckets.size();
+        PQNode top = buckets[cursor].back();
+        buckets[cursor].pop_back();
+        count--;
+        return top;
+    }
+
+    bool empty() const { return count == 0; }
+};
+
+typedef IndexedDaryHeap<4> FourAryHeap;
+
+#endif // PRIORITY_QUEUES_H
@@ -0,0 +1,79 @@
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include "CSRGraph.h"
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <functional>
+
+// --- Least-recently-used map with a fixed entry limit ---
+// find() refreshes an entry; put() evicts the stalest entry once the limit is
+// exceeded. A limit of 0 disables the cache.
+template <typename Key, typename Value, typename Hash = hash<Key>>
+class LRUCache {
+    typedef list<pair<Key, Value>> Entries;
+    Entries entries;   // most recently used first
+    unordered_map<Key, typename Entries::iterator, Hash> index;
+    size_t limit;
+
+    void trim() {
+        while (entries.size() > limit) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+public:
+    explicit LRUCache(size_t limit) : limit(limit) {}
+
+    Value* find(const Key& key) {
+        auto it = index.find(key);
+        if (it == index.end()) return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+
+    void put(const Key& key, Value value) {
+        if (limit == 0) return;
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = move(value);
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        entries.emplace_front(key, move(value));
+        index[key] = entries.begin();
+        trim();
+    }
+
+    void setCapacity(size_t n) { limit = n; trim(); }
+    size_t capacity() const { return limit; }
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); index.clear(); }
+};
+
+// Query kind plus its endpoints in ascending id order, so (a, b) and (b, a)
+// share an entry on the undirected network
+struct QueryKey {
+    uint32_t kind;
+    CityId a, b;
+    bool operator==(const QueryKey& o) const { return kind == o.kind && a == o.a && b == o.b; }
+};
+
+struct QueryKeyHash {
+    size_t operator()(const QueryKey& k) const {
+        uint64_t h = ((uint64_t)k.a << 32 | k.b) * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 29) ^ k.kind;
+    }
+};
+
+struct CacheStats {
+    long hits;       // answered from a cached result
+    long treeHits;   // answered from a cached shortest-path tree
+    long misses;     // needed a new search
+    int entries;
+    int trees;
+};
+
+#endif // QUERY_CACHE_H
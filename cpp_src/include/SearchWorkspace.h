@@ -0,0 +1,70 @@
+#ifndef SEARCH_WORKSPACE_H
+#define SEARCH_WORKSPACE_H
+
+#include "CSRGraph.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <vector>
+
+// --- Per-thread search scratch, reset in O(1) by bumping an epoch ---
+// dist/parent of a city are only valid while its stamp equals the current
+// epoch; any other city reads as unreached. The arrays grow to the id space
+// once and are then reused, so a query only touches the cities it explores.
+// Stamps are atomic so parallel traversals can claim cities without locks.
+class SearchWorkspace {
+    unique_ptr<atomic<uint32_t>[]> stamp;
+    vector<int> dists;
+    vector<CityId> parents;
+    size_t capacity = 0;
+    uint32_t epoch = 0;
+
+public:
+    // Starts a new query over ids [0, n)
+    void begin(size_t n) {
+        if (n > capacity) {
+            size_t grown = max(n, capacity * 2);
+            unique_ptr<atomic<uint32_t>[]> bigger(new atomic<uint32_t>[grown]);
+            for (size_t i = 0; i < grown; ++i) bigger[i].store(0, memory_order_relaxed);
+            stamp.swap(bigger);
+            dists.resize(grown);
+            parents.resize(grown);
+            capacity = grown;
+            epoch = 0;
+        }
+        if (++epoch == 0) {
+            for (size_t i = 0; i < capacity; ++i) stamp[i].store(0, memory_order_relaxed);
+            epoch = 1;
+        }
+    }
+
+    bool reached(CityId c) const { return stamp[c].load(memory_order_relaxed) == epoch; }
+    int dist(CityId c) const { return reached(c) ? dists[c] : INT_MAX; }
+    CityId parent(CityId c) const { return reached(c) ? parents[c] : NO_CITY; }
+
+    void set(CityId c, int d, CityId p) {
+        stamp[c].store(epoch, memory_order_relaxed);
+        dists[c] = d;
+        parents[c] = p;
+    }
+
+    // Marks c reached for this query; true only for the one caller that got there first
+    bool claim(CityId c) {
+        if (reached(c)) return false;
+        return stamp[c].exchange(epoch, memory_order_relaxed) != epoch;
+    }
+    // Fills in a city taken with claim()
+    void record(CityId c, int d, CityId p) {
+        dists[c] = d;
+        parents[c] = p;
+    }
+
+    // The calling thread's workspace; `slot` gives one search several at once
+    static SearchWorkspace& local(int slot = 0) {
+        static thread_local SearchWorkspace slots[2];
+        return slots[slot];
+    }
+};
+
+#endif // SEARCH_WORKSPACE_H
@@ -2,6 +2,8 @@
 #define SHORTEST_PATH_H
 
 #include "Graph.h"
+#include "PriorityQueues.h"
+#include "Landmarks.h"
 #include <string>
 #include <vector>
 
@@ -10,11 +12,74 @@ struct ShortestPathResult {
     vector<string> path;
     int distance;
     string message;
+    int settledNodes;   // cities settled by the search, for comparing modes
+};
+
+// Row-major |sources| x |targets| table of shortest distances
+struct DistanceMatrix {
+    int rows;
+    int cols;
+    vector<int> distances;   // -1 when unreachable or the city is unknown
+    string message;
+};
+
+// Full single-source result: distance and parent of every city (INT_MAX / NO_CITY if unreached)
+struct ShortestPathTree {
+    CityId source;
+    vector<int> dist;
+    vector<CityId> parent;
+};
+
+enum class SearchMode {
+    Dijkstra,        // unidirectional from start
+    Bidirectional,   // from both ends, stopping once the frontiers prove the meeting point
+    AStar,           // goal-directed by great-circle distance; Dijkstra if coordinates are missing
+    ContractionHierarchy, // upward search in a preprocessed hierarchy (PathFinder only)
+    ALT              // A* with landmark/triangle-inequality bounds (PathFinder only)
 };
 
 class ShortestPath {
 public:
+    // Dijkstra with the default queue policy (indexed 4-ary heap)
+    static ShortestPathResult find(Graph& g, string start, string end);
+
+    // Dijkstra with an explicit queue policy from PriorityQueues.h;
+    // instantiated for FourAryHeap, RadixHeap and DialBuckets
+    template <typename Queue>
     static ShortestPathResult find(Graph& g, string start, string end);
+
+    // Bidirectional Dijkstra; settles roughly two small balls instead of one large one
+    static ShortestPathResult findBidirectional(Graph& g, string start, string end);
+
+    // A* with a great-circle heuristic; needs coordinates on every city
+    // (Graph::setLocation), otherwise falls back to find()
+    static ShortestPathResult findAStar(Graph& g, string start, string end);
+
+    // A* with landmark lower bounds; `landmarks` must be built from g's current snapshot
+    static ShortestPathResult findALT(Graph& g, const Landmarks& landmarks, string start, string end);
+
+    // One Dijkstra from `source` that stops once every id in `targets` is settled.
+    // distances[i] receives d(source, targets[i]) or INT_MAX; when `parents` is
+    // given it receives the search tree (NO_CITY for unreached cities).
+    static void oneToMany(const CSRGraph& csr, CityId source, const vector<CityId>& targets,
+                          int* distances, vector<CityId>* parents = nullptr);
+
+    // One Dijkstra from `source` that stops at `target`, appending the cities
+    // after source up to and including target to `route` straight from the
+    // search tree. Returns the distance, or INT_MAX with `route` untouched.
+    static int pathBetween(const CSRGraph& csr, CityId source, CityId target,
+                           vector<CityId>& route);
+
+    // One Dijkstra from `source` that stops at the nearest other city with
+    // wanted[city] set, appending the path to it to `route` the same way.
+    // Returns that city, or NO_CITY with `distance` = INT_MAX if none is reachable.
+    static CityId pathToNearest(const CSRGraph& csr, CityId source, const vector<char>& wanted,
+                                vector<CityId>& route, int& distance);
+
+    // Dijkstra from `source` to every city
+    static void buildTree(const CSRGraph& csr, CityId source, ShortestPathTree& tree);
+    // Reads the path from tree.source to `target` without searching
+    static ShortestPathResult fromTree(Graph& g, const ShortestPathTree& tree, CityId target);
 };
 
 #endif // SHORTEST_PATH_H
@@ -0,0 +1,37 @@
+#ifndef TOUR_SEARCH_H
+#define TOUR_SEARCH_H
+
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+// --- Large-tour engine ---
+// Works on open tours that start at stop 0 and visit every stop once, over a
+// symmetric n x n distance table with every entry finite (the metric closure
+// of one connected component). A tour is the stop order, tour[0] == 0.
+class TourSearch {
+public:
+    typedef chrono::steady_clock::time_point Deadline;
+
+    static int cost(const vector<int>& dist, int n, const vector<int>& tour);
+
+    // Nearest-neighbour construction, then 2-opt and Or-opt until no move
+    // improves or `deadline` passes
+    static vector<int> heuristic(const vector<int>& dist, int n,
+                                 Deadline deadline = Deadline::max());
+
+    // Parallel branch and bound seeded with `tour` as the incumbent. Subtrees are
+    // spread over `threads` workers that steal from each other's deques, and
+    // nodes are pruned with a 1-tree bound (MST of the unvisited stops plus the
+    // cheapest edge into them). `tour` always holds the best tour found; returns
+    // true if the search finished before `deadline`, i.e. `tour` is optimal.
+    static bool branchAndBound(const vector<int>& dist, int n, vector<int>& tour,
+                               Deadline deadline, int threads);
+
+private:
+    static bool twoOpt(const vector<int>& dist, int n, vector<int>& tour, Deadline deadline);
+    static bool orOpt(const vector<int>& dist, int n, vector<int>& tour, Deadline deadline);
+};
+
+#endif // TOUR_SEARCH_H
@@ -0,0 +1,51 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+// --- Fixed set of worker threads that live as long as the pool ---
+// run() hands one job to every worker and runs it on the calling thread too,
+// returning once all copies have finished. The threads start on the first
+// run() and keep their thread_local search workspaces warm between runs.
+// Parallel algorithms size themselves with threadsHere(), so a job does not
+// start threads of its own on top of the pool's.
+class WorkerPool {
+    vector<thread> threads;
+    mutex runLock;   // held for the whole of a run()
+
+    mutex lock;   // guards everything below
+    condition_variable wake, done;
+    const function<void()>* job = nullptr;
+    uint64_t generation = 0;   // bumped once per run()
+    size_t running = 0;        // workers still inside the current job
+    bool stopping = false;
+
+    void loop(uint64_t seen);
+
+public:
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool();
+
+    // `job` must not throw. While another thread's run() holds the workers,
+    // the job runs on the calling thread alone.
+    void run(const function<void()>& job);
+
+    // Threads a parallel algorithm should use from the calling thread: 1 while
+    // it runs a pool job, since the other workers already keep every core
+    // busy, otherwise concurrency()
+    static int threadsHere();
+    // Cores the process may use: hardware_concurrency() unless set; 0 resets
+    static int concurrency();
+    static void setConcurrency(int threads);
+};
+
+#endif // WORKER_POOL_H
@@ -1,46 +1,178 @@
 #include "../include/CheapestNetwork.h"
+#include "../include/WorkerPool.h"
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 
-MSTResult CheapestNetwork::find(Graph& g) {
-    MSTResult res;
-    res.found = false;
-    res.totalCost = 0;
+// Ranges at or below this size are sorted outright by Filter-Kruskal
+static const size_t FILTER_KRUSKAL_BASE = 1024;
 
-    auto nodes = g.getNodes();
-    if (nodes.empty()) {
-        res.message = "Graph is empty.";
-        return res;
+// Strict order on routes: by weight, ties broken by city ids
+static bool lighter(const MSTEdge& a, const MSTEdge& b) {
+    if (a.weight != b.weight) return a.weight < b.weight;
+    if (a.u != b.u) return a.u < b.u;
+    return a.v < b.v;
+}
+
+static void sortAndScan(MSTEdge* first, MSTEdge* last, DisjointSet& ds, vector<MSTEdge>& tree) {
+    sort(first, last, lighter);
+    for (MSTEdge* e = first; e != last; ++e) {
+        // If cities are in different sets, adding this edge won't create a cycle
+        if (ds.unite(e->u, e->v)) tree.push_back(*e);
     }
+}
 
-    // Get all edges and sort by weight (Kruskal's algorithm)
-    auto edges = g.getAllEdges();
-    sort(edges.begin(), edges.end());
+void CheapestNetwork::kruskal(vector<MSTEdge>& edges, size_t numCities, vector<MSTEdge>& tree) {
+    DisjointSet ds(numCities);
+    sortAndScan(edges.data(), edges.data() + edges.size(), ds, tree);
+}
 
-    // Use DisjointSet for cycle detection
-    DisjointSet ds;
-    for (const auto& node : nodes) {
-        ds.makeSet(node);
+// Partition around a median-of-three pivot, solve the light half first, then
+// drop heavy routes whose ends it already joined before recursing on the rest
+static void filterKruskalRange(MSTEdge* first, MSTEdge* last, DisjointSet& ds, vector<MSTEdge>& tree) {
+    size_t n = last - first;
+    if (n <= FILTER_KRUSKAL_BASE) {
+        sortAndScan(first, last, ds, tree);
+        return;
     }
 
-    int edgeCount = 0;
-    for (const auto& edge : edges) {
-        int weight = get<0>(edge);
-        string u = get<1>(edge);
-        string v = get<2>(edge);
+    MSTEdge a = first[0], b = first[n / 2], c = last[-1];
+    MSTEdge pivot = lighter(a, b) ? (lighter(b, c) ? b : (lighter(a, c) ? c : a))
+                                  : (lighter(a, c) ? a : (lighter(b, c) ? c : b));
+    MSTEdge* mid = partition(first, last, [&](const MSTEdge& e) { return !lighter(pivot, e); });
+    if (mid == last) {
+        // Only possible with duplicate routes; nothing left to split on
+        sortAndScan(first, last, ds, tree);
+        return;
+    }
 
-        // If cities are in different sets, adding this edge won't create a cycle
-        if (ds.find(u) != ds.find(v)) {
-            ds.unite(u, v);
-            res.edges.push_back(make_tuple(u, v, weight));
-            res.totalCost += weight;
-            edgeCount++;
+    filterKruskalRange(first, mid, ds, tree);
+    MSTEdge* keep = remove_if(mid, last,
+                              [&](const MSTEdge& e) { return ds.find(e.u) == ds.find(e.v); });
+    filterKruskalRange(mid, keep, ds, tree);
+}
+
+void CheapestNetwork::filterKruskal(vector<MSTEdge>& edges, size_t numCities, vector<MSTEdge>& tree) {
+    DisjointSet ds(numCities);
+    filterKruskalRange(edges.data(), edges.data() + edges.size(), ds, tree);
+}
+
+// Lowers slot to key if key is smaller
+static void offer(atomic<uint64_t>& slot, uint64_t key) {
+    uint64_t cur = slot.load(memory_order_relaxed);
+    while (key < cur && !slot.compare_exchange_weak(cur, key, memory_order_relaxed)) {}
+}
+
+void CheapestNetwork::boruvka(vector<MSTEdge>& edges, size_t numCities, vector<MSTEdge>& tree) {
+    const uint64_t NONE = UINT64_MAX;
+    DisjointSet ds(numCities);
+    vector<uint32_t> comp(numCities);
+    // cheapest[r] = (weight << 32 | edge index) of the lightest route leaving tree r;
+    // the index breaks ties, so every round picks a forest
+    unique_ptr<atomic<uint64_t>[]> cheapest(new atomic<uint64_t>[numCities]);
+    int threads = WorkerPool::threadsHere();
+
+    while (!edges.empty()) {
+        for (size_t v = 0; v < numCities; ++v) {
+            comp[v] = ds.find(v);
+            cheapest[v].store(NONE, memory_order_relaxed);
+        }
+
+        // Tree labels are frozen in comp, so the scan only reads shared state
+        auto scan = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const MSTEdge& e = edges[i];
+                uint32_t cu = comp[e.u], cv = comp[e.v];
+                if (cu == cv) continue;
+                uint64_t key = (uint64_t)e.weight << 32 | i;
+                offer(cheapest[cu], key);
+                offer(cheapest[cv], key);
+            }
+        };
+        size_t m = edges.size();
+        size_t chunk = (m + threads - 1) / threads;
+        vector<thread> workers;
+        for (int t = 1; t < threads && t * chunk < m; ++t) {
+            workers.emplace_back(scan, t * chunk, min(m, (t + 1) * chunk));
+        }
+        scan(0, min(m, chunk));
+        for (auto& w : workers) w.join();
+
+        size_t before = tree.size();
+        for (size_t v = 0; v < numCities; ++v) {
+            uint64_t key = cheapest[v].load(memory_order_relaxed);
+            if (comp[v] != v || key == NONE) continue;
+            const MSTEdge& e = edges[(uint32_t)key];
+            // Both trees may have picked the same route; unite keeps it once
+            if (ds.unite(e.u, e.v)) tree.push_back(e);
         }
+        if (tree.size() == before) break;
+
+        edges.erase(remove_if(edges.begin(), edges.end(),
+                              [&](const MSTEdge& e) { return ds.find(e.u) == ds.find(e.v); }),
+                    edges.end());
+    }
+}
+
+vector<MSTEdge> CheapestNetwork::spanningForest(const CSRGraph& csr, MSTAlgorithm algorithm) {
+    // Each route once, as dense ids; no names are touched until the result
+    size_t n = csr.numCities();
+    vector<MSTEdge> edges;
+    edges.reserve(csr.numEdges() / 2);
+    for (CityId u = 0; u < n; ++u) {
+        for (const Edge& e : csr.neighbors(u)) {
+            if (u < e.dest) edges.push_back({e.weight, u, e.dest});
+        }
+    }
+
+    if (algorithm == MSTAlgorithm::Auto) {
+        if (edges.size() < LARGE_EDGE_COUNT) algorithm = MSTAlgorithm::Kruskal;
+        else if (WorkerPool::threadsHere() > 1) algorithm = MSTAlgorithm::Boruvka;
+        else algorithm = MSTAlgorithm::FilterKruskal;
+    }
+
+    vector<MSTEdge> tree;
+    if (algorithm == MSTAlgorithm::Boruvka) {
+        boruvka(edges, n, tree);
+    } else if (algorithm == MSTAlgorithm::FilterKruskal) {
+        filterKruskal(edges, n, tree);
+    } else {
+        kruskal(edges, n, tree);
+    }
+    return tree;
+}
+
+MSTResult CheapestNetwork::find(Graph& g, MSTAlgorithm algorithm) {
+    if (g.getCityCount() == 0) return describe(g, {});
+    return describe(g, spanningForest(g.snapshot(), algorithm));
+}
+
+MSTResult CheapestNetwork::describe(Graph& g, vector<MSTEdge> tree) {
+    MSTResult res;
+    res.found = false;
+    res.totalCost = 0;
+
+    int cityCount = g.getCityCount();
+    if (cityCount == 0) {
+        res.message = "Graph is empty.";
+        return res;
+    }
+
+    sort(tree.begin(), tree.end(), lighter);
+    for (const MSTEdge& e : tree) {
+        string_view a = g.getName(e.u);
+        string_view b = g.getName(e.v);
+        if (a < b) res.edges.emplace_back(a, b, e.weight);
+        else res.edges.emplace_back(b, a, e.weight);
+        res.totalCost += e.weight;
     }
+    int edgeCount = tree.size();
 
     // MST is always found, even if it's a forest (not fully connected)
     if (edgeCount > 0) {
         res.found = true;
-        if (edgeCount == (int)nodes.size() - 1) {
+        if (edgeCount == cityCount - 1) {
             res.message = "Minimum Spanning Tree found (fully connected).";
         } else {
             res.message = "Minimum Spanning Forest found (graph has multiple components).";
@@ -0,0 +1,321 @@
+#include "../include/ContractionHierarchy.h"
+#include "../include/PriorityQueues.h"
+#include <climits>
+
+namespace {
+
+struct CHEdge { CityId to; int weight; CityId middle; };
+
+// Witness searches give up after settling this many cities; a missed witness
+// only costs an unnecessary shortcut, never a wrong answer. Priority estimates
+// use a cheaper search than the real contraction.
+const int WITNESS_SETTLE_LIMIT = 500;
+const int ESTIMATE_SETTLE_LIMIT = 20;
+
+class Contractor {
+public:
+    vector<vector<CHEdge>> adj;     // edges among uncontracted cities only
+    vector<int> contractedNeighbors;
+
+    vector<int> witnessDist;
+    vector<char> targetMark;
+    vector<CityId> touched;
+    FourAryHeap heap;
+
+    explicit Contractor(const CSRGraph& csr) {
+        size_t n = csr.numCities();
+        adj.resize(n);
+        contractedNeighbors.assign(n, 0);
+        witnessDist.assign(n, INT_MAX);
+        targetMark.assign(n, 0);
+        for (CityId u = 0; u < n; ++u) {
+            for (const Edge& e : csr.neighbors(u)) {
+                if (e.dest != u) addOrLower(u, e.dest, e.weight, NO_CITY);
+            }
+        }
+    }
+
+    // Keeps only the lightest edge between a pair of cities
+    void addOrLower(CityId u, CityId w, int weight, CityId middle) {
+        for (CHEdge& e : adj[u]) {
+            if (e.to == w) {
+                if (weight < e.weight) { e.weight = weight; e.middle = middle; }
+                return;
+            }
+        }
+        adj[u].push_back({w, weight, middle});
+    }
+
+    // Dijkstra from `source` that never passes through `skip`; stops once every
+    // city flagged in targetMark has been settled
+    void witnessSearch(CityId source, CityId skip, int maxDist, int settleLimit, int targets) {
+        for (CityId c : touched) witnessDist[c] = INT_MAX;
+        touched.clear();
+        heap.reset(adj.size(), 0);
+
+        witnessDist[source] = 0;
+        touched.push_back(source);
+        heap.push(source, 0);
+        int settled = 0;
+
+        while (!heap.empty()) {
+            PQNode top = heap.pop();
+            if (top.weight > maxDist || ++settled > settleLimit) break;
+            if (targetMark[top.city] && --targets == 0) break;
+            for (const CHEdge& e : adj[top.city]) {
+                if (e.to == skip) continue;
+                int nd = top.weight + e.weight;
+                if (nd < witnessDist[e.to]) {
+                    if (witnessDist[e.to] == INT_MAX) touched.push_back(e.to);
+                    witnessDist[e.to] = nd;
+                    heap.push(e.to, nd);
+                }
+            }
+        }
+    }
+
+    // Adds (or, when simulating, counts) the shortcuts contracting v needs
+    int contract(CityId v, bool simulate) {
+        const vector<CHEdge>& edges = adj[v];
+        int added = 0;
+
+        for (size_t i = 0; i + 1 < edges.size(); ++i) {
+            int maxDist = 0;
+            for (size_t j = i + 1; j < edges.size(); ++j) {
+                targetMark[edges[j].to] = 1;
+                if (edges[i].weight + edges[j].weight > maxDist) {
+                    maxDist = edges[i].weight + edges[j].weight;
+                }
+            }
+            witnessSearch(edges[i].to, v, maxDist,
+                          simulate ? ESTIMATE_SETTLE_LIMIT : WITNESS_SETTLE_LIMIT,
+                          edges.size() - i - 1);
+            for (size_t j = i + 1; j < edges.size(); ++j) targetMark[edges[j].to] = 0;
+
+            // Each unordered pair is handled from its lower index
+            for (size_t j = i + 1; j < edges.size(); ++j) {
+                int via = edges[i].weight + edges[j].weight;
+                if (witnessDist[edges[j].to] <= via) continue;
+                added++;
+                if (!simulate) {
+                    addOrLower(edges[i].to, edges[j].to, via, v);
+                    addOrLower(edges[j].to, edges[i].to, via, v);
+                }
+            }
+        }
+        return added;
+    }
+
+    int priority(CityId v) {
+        int shortcuts = contract(v, true);
+        return shortcuts - (int)adj[v].size() + contractedNeighbors[v];
+    }
+
+    void detach(CityId v) {
+        for (const CHEdge& e : adj[v]) {
+            auto& back = adj[e.to];
+            for (size_t i = 0; i < back.size(); ++i) {
+                if (back[i].to == v) {
+                    back[i] = back.back();
+                    back.pop_back();
+                    break;
+                }
+            }
+            contractedNeighbors[e.to]++;
+        }
+    }
+};
+
+// Per-thread query state; only touched entries are reset between queries
+struct CHQueryState {
+    vector<int> dist[2];
+    vector<CityId> parent[2];
+    vector<CityId> touched;
+    FourAryHeap queues[2];
+
+    void prepare(size_t n) {
+        for (CityId c : touched) {
+            dist[0][c] = dist[1][c] = INT_MAX;
+        }
+        touched.clear();
+        for (int side = 0; side < 2; ++side) {
+            if (dist[side].size() < n) {
+                dist[side].resize(n, INT_MAX);
+                parent[side].resize(n, NO_CITY);
+            }
+            queues[side].reset(n, 0);
+        }
+    }
+};
+
+} // namespace
+
+void ContractionHierarchy::build(const CSRGraph& csr) {
+    size_t n = csr.numCities();
+    Contractor c(csr);
+
+    FourAryHeap order;
+    order.reset(n, 0);
+    for (CityId v = 0; v < n; ++v) order.push(v, c.priority(v));
+
+    rank.assign(n, 0);
+    vector<vector<CHEdge>> up(n);
+    shortcuts = 0;
+    uint32_t next = 0;
+
+    while (!order.empty()) {
+        CityId v = order.pop().city;
+
+        // Lazy update: priorities drift as neighbours get contracted
+        int p = c.priority(v);
+        if (!order.empty() && p > order.top().weight) {
+            order.push(v, p);
+            continue;
+        }
+
+        shortcuts += c.contract(v, false);
+        rank[v] = next++;
+        up[v] = c.adj[v];
+        c.detach(v);
+        c.adj[v].clear();
+        c.adj[v].shrink_to_fit();
+
+        for (const CHEdge& e : up[v]) order.push(e.to, c.priority(e.to));
+    }
+
+    upOffsets.assign(n + 1, 0);
+    for (CityId v = 0; v < n; ++v) upOffsets[v + 1] = upOffsets[v] + up[v].size();
+    upTargets.resize(upOffsets[n]);
+    upWeights.resize(upOffsets[n]);
+    upMiddle.resize(upOffsets[n]);
+    for (CityId v = 0; v < n; ++v) {
+        uint32_t pos = upOffsets[v];
+        for (const CHEdge& e : up[v]) {
+            upTargets[pos] = e.to;
+            upWeights[pos] = e.weight;
+            upMiddle[pos] = e.middle;
+            pos++;
+        }
+    }
+}
+
+// The bypassed city of edge a-b; the edge is stored at the lower-ranked end
+CityId ContractionHierarchy::middleOf(CityId a, CityId b) const {
+    CityId low = rank[a] < rank[b] ? a : b;
+    CityId high = low == a ? b : a;
+    for (uint32_t i = upOffsets[low]; i < upOffsets[low + 1]; ++i) {
+        if (upTargets[i] == high) return upMiddle[i];
+    }
+    return NO_CITY;
+}
+
+// Appends the original cities after `from` up to and including `to`
+void ContractionHierarchy::unpack(CityId from, CityId to, vector<CityId>& out) const {
+    vector<pair<CityId, CityId>> pending = {{from, to}};
+    while (!pending.empty()) {
+        auto [a, b] = pending.back();
+        pending.pop_back();
+        CityId mid = middleOf(a, b);
+        if (mid == NO_CITY) {
+            out.push_back(b);
+        } else {
+            pending.push_back({mid, b});
+            pending.push_back({a, mid});
+        }
+    }
+}
+
+ShortestPathResult ContractionHierarchy::query(Graph& g, string start, string end) const {
+    ShortestPathResult res;
+    res.found = false;
+    res.distance = 0;
+    res.settledNodes = 0;
+
+    CityId s = g.findCity(start);
+    CityId t = g.findCity(end);
+
+    if (s == NO_CITY || t == NO_CITY) {
+        res.message = "One or both cities not found in the network.";
+        return res;
+    }
+    if (!g.connected(s, t)) {
+        res.message = "No route exists between these cities.";
+        return res;
+    }
+
+    static thread_local CHQueryState st;
+    st.prepare(rank.size());
+
+    CityId sources[2] = {s, t};
+    for (int side = 0; side < 2; ++side) {
+        st.dist[side][sources[side]] = 0;
+        st.touched.push_back(sources[side]);
+        st.queues[side].push(sources[side], 0);
+    }
+
+    int best = INT_MAX;
+    CityId meet = NO_CITY;
+    bool active[2] = {true, true};
+
+    while (active[0] || active[1]) {
+        for (int side = 0; side < 2; ++side) {
+            if (!active[side]) continue;
+            if (st.queues[side].empty()) { active[side] = false; continue; }
+
+            PQNode top = st.queues[side].pop();
+            // Everything left on this side is at least as far as `best`
+            if (top.weight >= best) { active[side] = false; continue; }
+            CityId u = top.city;
+
+            int other = st.dist[1 - side][u];
+            if (other != INT_MAX && top.weight + other < best) {
+                best = top.weight + other;
+                meet = u;
+            }
+
+            // Stall-on-demand: if a higher city already reaches u more cheaply,
+            // u's tentative distance is not final and relaxing it is wasted work
+            bool stalled = false;
+            for (uint32_t i = upOffsets[u]; i < upOffsets[u + 1] && !stalled; ++i) {
+                int dv = st.dist[side][upTargets[i]];
+                stalled = dv != INT_MAX && dv + upWeights[i] < top.weight;
+            }
+            if (stalled) continue;
+            res.settledNodes++;
+
+            for (uint32_t i = upOffsets[u]; i < upOffsets[u + 1]; ++i) {
+                CityId v = upTargets[i];
+                int nd = top.weight + upWeights[i];
+                if (nd < st.dist[side][v]) {
+                    if (st.dist[0][v] == INT_MAX && st.dist[1][v] == INT_MAX) st.touched.push_back(v);
+                    st.dist[side][v] = nd;
+                    st.parent[side][v] = u;
+                    st.queues[side].push(v, nd);
+                }
+            }
+        }
+    }
+
+    if (meet == NO_CITY) {
+        res.message = "No route exists between these cities.";
+        return res;
+    }
+
+    // Upward chain s -> meet, walked backwards from the meeting city
+    vector<CityId> chain = {meet};
+    while (chain.back() != s) chain.push_back(st.parent[0][chain.back()]);
+
+    vector<CityId> ids = {s};
+    for (size_t i = chain.size() - 1; i > 0; --i) unpack(chain[i], chain[i - 1], ids);
+
+    // Downward chain meet -> t
+    for (CityId curr = meet; curr != t; curr = st.parent[1][curr]) {
+        unpack(curr, st.parent[1][curr], ids);
+    }
+
+    res.found = true;
+    res.distance = best;
+    for (CityId id : ids) res.path.emplace_back(g.getName(id));
+    res.message = "Shortest path found successfully.";
+    return res;
+}
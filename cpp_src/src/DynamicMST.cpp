@@ -0,0 +1,178 @@
+#include "../include/DynamicMST.h"
+#include <algorithm>
+
+void DynamicMST::clear() {
+    isBuilt = false;
+    forest.clear();
+}
+
+void DynamicMST::grow(size_t ids) {
+    if (forest.size() >= ids) return;
+    forest.resize(ids);
+    mark.resize(ids, 0);
+    parent.resize(ids);
+    parentWeight.resize(ids);
+}
+
+uint32_t DynamicMST::nextStamp() {
+    if (stamp >= UINT32_MAX - 2) {
+        fill(mark.begin(), mark.end(), 0);
+        stamp = 0;
+    }
+    stamp += 2;
+    return stamp;
+}
+
+int DynamicMST::forestWeight(CityId u, CityId v) const {
+    for (const Edge& e : forest[u]) {
+        if (e.dest == v) return e.weight;
+    }
+    return -1;
+}
+
+void DynamicMST::link(CityId u, CityId v, int weight) {
+    forest[u].push_back({v, weight});
+    forest[v].push_back({u, weight});
+}
+
+void DynamicMST::cut(CityId u, CityId v) {
+    auto drop = [](vector<Edge>& routes, CityId to) {
+        for (size_t i = 0; i < routes.size(); ++i) {
+            if (routes[i].dest == to) {
+                routes[i] = routes.back();
+                routes.pop_back();
+                return;
+            }
+        }
+    };
+    drop(forest[u], v);
+    drop(forest[v], u);
+}
+
+void DynamicMST::build(Graph& g) {
+    forest.clear();
+    grow(g.idCount());
+    for (const MSTEdge& e : CheapestNetwork::spanningForest(g.snapshot())) link(e.u, e.v, e.weight);
+    isBuilt = true;
+}
+
+void DynamicMST::build(Graph& g, const MappedArray<MSTEdge>& saved) {
+    forest.clear();
+    grow(g.idCount());
+    for (const MSTEdge& e : saved) link(e.u, e.v, e.weight);
+    isBuilt = true;
+}
+
+void DynamicMST::onRouteSet(Graph& g, CityId u, CityId v, int weight) {
+    if (!isBuilt || u == v) return;
+    grow(g.idCount());
+
+    int old = forestWeight(u, v);
+    if (old >= 0) {
+        // A cheaper forest route stays optimal; a dearer one may lose to a rival
+        if (weight <= old) {
+            cut(u, v);
+            link(u, v, weight);
+        } else {
+            cut(u, v);
+            reconnect(g, u, v);
+        }
+        return;
+    }
+
+    // Walk the forest from u; if v is in the same tree, the route closes a cycle
+    uint32_t s = nextStamp();
+    vector<CityId> queue = {u};
+    mark[u] = s;
+    for (size_t head = 0; head < queue.size() && mark[v] != s; ++head) {
+        CityId c = queue[head];
+        for (const Edge& e : forest[c]) {
+            if (mark[e.dest] == s) continue;
+            mark[e.dest] = s;
+            parent[e.dest] = c;
+            parentWeight[e.dest] = e.weight;
+            queue.push_back(e.dest);
+        }
+    }
+    if (mark[v] != s) {
+        link(u, v, weight);
+        return;
+    }
+
+    // Swap out the heaviest route on the cycle if the new one beats it
+    CityId a = NO_CITY, b = NO_CITY;
+    int heaviest = -1;
+    for (CityId c = v; c != u; c = parent[c]) {
+        if (parentWeight[c] > heaviest) {
+            heaviest = parentWeight[c];
+            a = c;
+            b = parent[c];
+        }
+    }
+    if (heaviest > weight) {
+        cut(a, b);
+        link(u, v, weight);
+    }
+}
+
+void DynamicMST::onRouteRemoved(Graph& g, CityId u, CityId v) {
+    if (!isBuilt || forestWeight(u, v) < 0) return;
+    cut(u, v);
+    reconnect(g, u, v);
+}
+
+// u and v were just split apart. Grow both halves in lockstep so the first
+// to run out is the smaller one, then take the cheapest live route leaving it;
+// every such route lands in the other half.
+void DynamicMST::reconnect(Graph& g, CityId u, CityId v) {
+    uint32_t s = nextStamp();
+    vector<CityId> sideU = {u}, sideV = {v};
+    mark[u] = s;
+    mark[v] = s + 1;
+
+    auto expand = [&](vector<CityId>& side, size_t& head, uint32_t tag) {
+        CityId c = side[head++];
+        for (const Edge& e : forest[c]) {
+            if (mark[e.dest] == tag) continue;
+            mark[e.dest] = tag;
+            side.push_back(e.dest);
+        }
+    };
+    size_t headU = 0, headV = 0;
+    while (headU < sideU.size() && headV < sideV.size()) {
+        expand(sideU, headU, s);
+        if (headU < sideU.size()) expand(sideV, headV, s + 1);
+    }
+    bool uSmaller = headU == sideU.size();
+    const vector<CityId>& small = uSmaller ? sideU : sideV;
+    uint32_t tag = uSmaller ? s : s + 1;
+
+    CityId from = NO_CITY, to = NO_CITY;
+    int best = -1;
+    for (CityId c : small) {
+        for (const Edge& e : g.routesOf(c)) {
+            if (mark[e.dest] == tag) continue;
+            if (best < 0 || e.weight < best) {
+                best = e.weight;
+                from = c;
+                to = e.dest;
+            }
+        }
+    }
+    if (best >= 0) link(from, to, best);
+}
+
+MSTResult DynamicMST::result(Graph& g) {
+    if (!isBuilt) build(g);
+    return CheapestNetwork::describe(g, edges());
+}
+
+vector<MSTEdge> DynamicMST::edges() const {
+    vector<MSTEdge> tree;
+    for (CityId u = 0; u < forest.size(); ++u) {
+        for (const Edge& e : forest[u]) {
+            if (u < e.dest) tree.push_back({e.weight, u, e.dest});
+        }
+    }
+    return tree;
+}
@@ -0,0 +1,142 @@
+#include "../include/DynamicSPT.h"
+#include <algorithm>
+#include <climits>
+
+void DynamicSPT::setSources(Graph& g, const vector<CityId>& sources) {
+    clear();
+    const CSRGraph& csr = g.snapshot();
+    for (CityId s : sources) {
+        if (s == NO_CITY || find(roots.begin(), roots.end(), s) != roots.end()) continue;
+        roots.push_back(s);
+        trees.emplace_back();
+        ShortestPath::buildTree(csr, s, trees.back());
+    }
+}
+
+void DynamicSPT::clear() {
+    roots.clear();
+    trees.clear();
+}
+
+void DynamicSPT::grow(ShortestPathTree& tree, size_t ids) {
+    if (tree.dist.size() < ids) {
+        tree.dist.resize(ids, INT_MAX);
+        tree.parent.resize(ids, NO_CITY);
+    }
+    if (inSubtree.size() < ids) inSubtree.resize(ids, 0);
+}
+
+uint32_t DynamicSPT::nextStamp() {
+    if (++stamp == 0) {
+        fill(inSubtree.begin(), inSubtree.end(), 0);
+        stamp = 1;
+    }
+    return stamp;
+}
+
+void DynamicSPT::onRouteSet(Graph& g, CityId u, CityId v, int weight) {
+    if (u == v) return;
+    for (ShortestPathTree& tree : trees) {
+        grow(tree, g.idCount());
+
+        // A tree route keeps its old weight in the distances it separates
+        CityId from = NO_CITY, to = NO_CITY;
+        if (tree.parent[v] == u) from = u, to = v;
+        else if (tree.parent[u] == v) from = v, to = u;
+
+        if (from == NO_CITY) {
+            improve(g, tree, u, v, weight);
+            improve(g, tree, v, u, weight);
+        } else if (weight < tree.dist[to] - tree.dist[from]) {
+            improve(g, tree, from, to, weight);
+        } else if (weight > tree.dist[to] - tree.dist[from]) {
+            lengthen(g, tree, to);
+        }
+    }
+}
+
+void DynamicSPT::onRouteRemoved(Graph& g, CityId u, CityId v) {
+    for (ShortestPathTree& tree : trees) {
+        grow(tree, g.idCount());
+        if (tree.parent[v] == u) lengthen(g, tree, v);
+        else if (tree.parent[u] == v) lengthen(g, tree, u);
+    }
+}
+
+// The route from -> to may now offer `to` a shorter distance; spread it until
+// distances stop dropping
+void DynamicSPT::improve(Graph& g, ShortestPathTree& tree, CityId from, CityId to, int weight) {
+    if (tree.dist[from] == INT_MAX || tree.dist[from] + weight >= tree.dist[to]) return;
+    tree.dist[to] = tree.dist[from] + weight;
+    tree.parent[to] = from;
+    pq.reset(tree.dist.size(), 0);
+    pq.push(to, tree.dist[to]);
+    settle(g, tree);
+}
+
+// The route into `child` got dearer or vanished: every city hanging below it
+// loses its distance, then takes the best offer from a neighbour outside the
+// subtree and the usual Dijkstra settles the rest
+void DynamicSPT::lengthen(Graph& g, ShortestPathTree& tree, CityId child) {
+    uint32_t s = nextStamp();
+    subtree.clear();
+    subtree.push_back(child);
+    inSubtree[child] = s;
+    for (size_t head = 0; head < subtree.size(); ++head) {
+        CityId c = subtree[head];
+        for (const Edge& e : g.routesOf(c)) {
+            if (tree.parent[e.dest] == c && inSubtree[e.dest] != s) {
+                inSubtree[e.dest] = s;
+                subtree.push_back(e.dest);
+            }
+        }
+    }
+    for (CityId c : subtree) {
+        tree.dist[c] = INT_MAX;
+        tree.parent[c] = NO_CITY;
+    }
+
+    pq.reset(tree.dist.size(), 0);
+    for (CityId c : subtree) {
+        for (const Edge& e : g.routesOf(c)) {
+            if (inSubtree[e.dest] == s || tree.dist[e.dest] == INT_MAX) continue;
+            if (tree.dist[e.dest] + e.weight < tree.dist[c]) {
+                tree.dist[c] = tree.dist[e.dest] + e.weight;
+                tree.parent[c] = e.dest;
+            }
+        }
+        if (tree.dist[c] != INT_MAX) pq.push(c, tree.dist[c]);
+    }
+    settle(g, tree);
+}
+
+void DynamicSPT::settle(Graph& g, ShortestPathTree& tree) {
+    while (!pq.empty()) {
+        PQNode top = pq.pop();
+        for (const Edge& e : g.routesOf(top.city)) {
+            int newDist = top.weight + e.weight;
+            if (newDist < tree.dist[e.dest]) {
+                tree.dist[e.dest] = newDist;
+                tree.parent[e.dest] = top.city;
+                pq.push(e.dest, newDist);
+            }
+        }
+    }
+}
+
+bool DynamicSPT::query(Graph& g, CityId s, CityId t, ShortestPathResult& res) const {
+    for (size_t i = 0; i < roots.size(); ++i) {
+        if (roots[i] != s && roots[i] != t) continue;
+        // Every route edit grows the trees, so a city with routes is always covered
+        const ShortestPathTree& tree = trees[i];
+        if (max(s, t) >= tree.dist.size()) return false;
+        if (roots[i] == s) {
+            res = ShortestPath::fromTree(g, tree, t);
+        } else {
+            res = ShortestPath::fromTree(g, tree, s);
+            reverse(res.path.begin(), res.path.end());
+        }
+        return true;
+    }
+    return false;
+}
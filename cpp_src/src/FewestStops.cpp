@@ -1,5 +1,167 @@
 #include "../include/FewestStops.h"
-#include <map>
+#include "../include/WorkerPool.h"
+#include <algorithm>
+#include <thread>
+
+// Switch thresholds from Beamer et al.: go bottom-up once the frontier's routes
+// exceed 1/ALPHA of the unexplored ones, back to top-down once the frontier
+// holds fewer than 1/BETA of all cities
+static const size_t ALPHA = 14;
+static const size_t BETA = 24;
+
+// Levels with less work than this are expanded on the calling thread
+static const size_t PARALLEL_MIN_WORK = 1 << 14;
+
+struct ExploreBuffers {
+    vector<uint64_t> frontierBits, nextBits;
+    vector<CityId> frontier;
+    vector<vector<CityId>> localNext;   // per chunk worker
+};
+
+// Runs body(begin, end, worker) over [0, n) in one chunk per worker; chunk
+// boundaries are multiples of 64 so bitmap words are never shared
+template <typename Body>
+static void forChunks(size_t n, int threads, Body body) {
+    if (threads <= 1) {
+        body(0, n, 0);
+        return;
+    }
+    size_t chunk = ((n + threads - 1) / threads + 63) & ~(size_t)63;
+    vector<thread> helpers;
+    for (int t = 1; t < threads && t * chunk < n; ++t) {
+        helpers.emplace_back(body, t * chunk, min(n, (t + 1) * chunk), t);
+    }
+    body(0, min(n, chunk), 0);
+    for (auto& h : helpers) h.join();
+}
+
+// Hop counts land in ws as distances, BFS parents as parents. Only the
+// bottom-up levels, which run once the search covers much of the graph, look
+// at every city.
+void FewestStops::explore(const CSRGraph& csr, const vector<CityId>& sources,
+                          SearchWorkspace& ws, CityId stopAt) {
+    size_t n = csr.numCities();
+    size_t words = (n + 63) / 64;
+    ws.begin(n);
+
+    // Kept per calling thread; the bitmaps are only sized once a level goes
+    // bottom-up. The chunk workers reach them through these references, never
+    // through their own (empty) thread_local copies.
+    static thread_local ExploreBuffers buffers;
+    vector<uint64_t>& frontierBits = buffers.frontierBits;
+    vector<uint64_t>& nextBits = buffers.nextBits;
+    vector<CityId>& frontier = buffers.frontier;
+    vector<vector<CityId>>& localNext = buffers.localNext;
+    frontier.clear();
+
+    size_t unexplored = csr.numEdges();
+    size_t frontierEdges = 0;
+    for (CityId s : sources) {
+        if (s == NO_CITY || ws.reached(s)) continue;
+        ws.set(s, 0, NO_CITY);
+        frontier.push_back(s);
+        frontierEdges += csr.degree(s);
+    }
+    unexplored -= frontierEdges;
+    size_t frontierSize = frontier.size();
+
+    int threads = WorkerPool::threadsHere();
+    localNext.resize(max<size_t>(localNext.size(), threads));
+    vector<size_t> localSize(threads), localEdges(threads);
+    bool bottomUp = false, asBits = false;
+
+    for (int level = 1; frontierSize > 0; ++level) {
+        if (stopAt != NO_CITY && ws.reached(stopAt)) break;
+
+        if (!bottomUp && frontierEdges > unexplored / ALPHA) bottomUp = true;
+        else if (bottomUp && frontierSize < n / BETA) bottomUp = false;
+
+        // Convert the frontier to the representation this level reads
+        if (bottomUp && !asBits) {
+            frontierBits.assign(words, 0);
+            nextBits.resize(words);
+            for (CityId u : frontier) frontierBits[u >> 6] |= (uint64_t)1 << (u & 63);
+            asBits = true;
+        } else if (!bottomUp && asBits) {
+            frontier.clear();
+            for (size_t w = 0; w < words; ++w) {
+                for (uint64_t bits = frontierBits[w]; bits; bits &= bits - 1) {
+                    frontier.push_back(w * 64 + __builtin_ctzll(bits));
+                }
+            }
+            asBits = false;
+        }
+
+        fill(localSize.begin(), localSize.end(), 0);
+        fill(localEdges.begin(), localEdges.end(), 0);
+
+        if (!bottomUp) {
+            // Top-down: each frontier city claims its unvisited neighbours
+            forChunks(frontier.size(), frontierEdges < PARALLEL_MIN_WORK ? 1 : threads,
+                      [&](size_t begin, size_t end, int t) {
+                vector<CityId>& next = localNext[t];
+                next.clear();
+                for (size_t i = begin; i < end; ++i) {
+                    CityId u = frontier[i];
+                    for (const Edge& e : csr.neighbors(u)) {
+                        if (!ws.claim(e.dest)) continue;
+                        ws.record(e.dest, level, u);
+                        next.push_back(e.dest);
+                        localEdges[t] += csr.degree(e.dest);
+                    }
+                }
+                localSize[t] = next.size();
+            });
+            frontier.clear();
+            for (int t = 0; t < threads; ++t) {
+                frontier.insert(frontier.end(), localNext[t].begin(), localNext[t].begin() + localSize[t]);
+            }
+        } else {
+            // Bottom-up: each unvisited city stops at its first neighbour in the frontier
+            forChunks(n, n < PARALLEL_MIN_WORK ? 1 : threads, [&](size_t begin, size_t end, int t) {
+                for (size_t w = begin / 64; w * 64 < end; ++w) {
+                    uint64_t found = 0;
+                    for (size_t v = w * 64; v < min(end, w * 64 + 64); ++v) {
+                        if (ws.reached(v)) continue;
+                        for (const Edge& e : csr.neighbors(v)) {
+                            if ((frontierBits[e.dest >> 6] >> (e.dest & 63)) & 1) {
+                                found |= (uint64_t)1 << (v & 63);
+                                ws.set(v, level, e.dest);
+                                localSize[t]++;
+                                localEdges[t] += csr.degree(v);
+                                break;
+                            }
+                        }
+                    }
+                    nextBits[w] = found;
+                }
+            });
+            frontierBits.swap(nextBits);
+        }
+
+        frontierSize = 0;
+        frontierEdges = 0;
+        for (int t = 0; t < threads; ++t) {
+            frontierSize += localSize[t];
+            frontierEdges += localEdges[t];
+        }
+        unexplored -= frontierEdges;
+    }
+}
+
+void FewestStops::bfs(const CSRGraph& csr, const vector<CityId>& sources, vector<int>& hops,
+                      vector<CityId>* parents, CityId stopAt) {
+    SearchWorkspace& ws = SearchWorkspace::local();
+    explore(csr, sources, ws, stopAt);
+
+    size_t n = csr.numCities();
+    hops.resize(n);
+    for (CityId c = 0; c < n; ++c) hops[c] = ws.reached(c) ? ws.dist(c) : -1;
+    if (parents) {
+        parents->resize(n);
+        for (CityId c = 0; c < n; ++c) (*parents)[c] = ws.parent(c);
+    }
+}
 
 FewestStopsResult FewestStops::find(Graph& g, string start, string end) {
     FewestStopsResult res;
@@ -7,60 +169,33 @@ FewestStopsResult FewestStops::find(Graph& g, string start, string end) {
     res.stops = 0;
 
     // Check if cities exist
-    auto nodes = g.getNodes();
-    bool startExists = false, endExists = false;
-    for (const auto& n : nodes) {
-        if (n == start) startExists = true;
-        if (n == end) endExists = true;
-    }
+    CityId s = g.findCity(start);
+    CityId t = g.findCity(end);
 
-    if (!startExists || !endExists) {
+    if (s == NO_CITY || t == NO_CITY) {
         res.message = "One or both cities not found in the network.";
         return res;
     }
+    if (!g.connected(s, t)) {
+        res.message = "No path exists between these cities.";
+        return res;
+    }
 
-    map<string, bool> visited;
-    map<string, string> parent;
-    CustomQueue<string> q;
-
-    q.enqueue(start);
-    visited[start] = true;
-
-    while (!q.empty()) {
-        string u = q.front(); 
-        q.dequeue();
-        
-        if (u == end) {
-            res.found = true;
-            res.message = "Path found with fewest stops.";
-            
-            // Reconstruct path using CustomStack
-            CustomStack<string> pathStack;
-            string curr = end;
-            while (curr != start) {
-                pathStack.push(curr);
-                curr = parent[curr];
-            }
-            pathStack.push(start);
-
-            while (!pathStack.empty()) {
-                res.path.push_back(pathStack.top());
-                pathStack.pop();
-            }
-            
-            res.stops = res.path.size() - 1;
-            return res;
-        }
+    SearchWorkspace& ws = SearchWorkspace::local();
+    explore(g.snapshot(), {s}, ws, t);
 
-        for (const auto& e : g.getNeighbors(u)) {
-            if (!visited[e.dest]) {
-                visited[e.dest] = true;
-                parent[e.dest] = u;
-                q.enqueue(e.dest);
-            }
-        }
+    if (!ws.reached(t)) {
+        res.message = "No path exists between these cities.";
+        return res;
     }
 
-    res.message = "No path exists between these cities.";
+    vector<CityId> route;
+    for (CityId curr = t; curr != s; curr = ws.parent(curr)) route.push_back(curr);
+    route.push_back(s);
+    for (auto it = route.rbegin(); it != route.rend(); ++it) res.path.emplace_back(g.getName(*it));
+
+    res.found = true;
+    res.stops = ws.dist(t);
+    res.message = "Path found with fewest stops.";
     return res;
 }
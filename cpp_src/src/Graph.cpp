@@ -1,139 +1,326 @@
 #include "../include/Graph.h"
 #include <algorithm>
 
-string toLower(string s) {
-    transform(s.begin(), s.end(), s.begin(), ::tolower);
-    return s;
+// Copies what a snapshot lent out into owned storage, so the graph can be edited
+void Graph::materialize() {
+    if (!mapped) return;
+    size_t n = names.size();
+    adjList.assign(n, {});
+    for (CityId u = 0; u < n; ++u) {
+        NeighborRange routes = csr.neighbors(u);
+        adjList[u].assign(routes.begin(), routes.end());
+    }
+    mapped = false;
+}
+
+CityId Graph::intern(string_view name) {
+    materialize();
+    CityId id = index.insert(name, names.size());
+    if (id == names.size()) {
+        names.push_back(name);
+        adjList.emplace_back();
+        latitude.edit().push_back(NAN);
+        longitude.edit().push_back(NAN);
+        comp.push_back(id);
+        members.push_back({id});
+        compDirty.push_back(0);
+    }
+    return id;
+}
+
+void Graph::mergeComponents(CityId u, CityId v) {
+    CityId a = comp[u], b = comp[v];
+    if (a == b) return;
+    if (members[a].size() < members[b].size()) swap(a, b);
+    for (CityId c : members[b]) comp[c] = a;
+    members[a].insert(members[a].end(), members[b].begin(), members[b].end());
+    members[b].clear();
+    compDirty[a] = compDirty[a] || compDirty[b];
+    compDirty[b] = 0;
+}
+
+// Relabel a flagged component by BFS; each piece is labelled by its first city
+void Graph::splitComponent(CityId label) {
+    vector<CityId> old;
+    old.swap(members[label]);
+    compDirty[label] = 0;
+    for (CityId c : old) comp[c] = NO_CITY;
+
+    for (CityId start : old) {
+        if (comp[start] != NO_CITY) continue;
+        vector<CityId>& piece = members[start];
+        comp[start] = start;
+        piece.push_back(start);
+        for (size_t head = 0; head < piece.size(); ++head) {
+            for (const Edge& e : adjList[piece[head]]) {
+                if (comp[e.dest] != NO_CITY) continue;
+                comp[e.dest] = start;
+                piece.push_back(e.dest);
+            }
+        }
+    }
+}
+
+CityId Graph::componentOf(CityId id) {
+    if (compDirty[comp[id]]) splitComponent(comp[id]);
+    return comp[id];
+}
+
+void Graph::freeze() {
+    snapshot();
+    for (CityId label = 0; label < compDirty.size(); ++label) {
+        if (compDirty[label]) splitComponent(label);
+    }
+}
+
+CityId Graph::findCity(string_view name) const {
+    CityId id = index.find(name);
+    if (id == NO_CITY || degreeOf(id) == 0) return NO_CITY;
+    return id;
+}
+
+void Graph::eraseHalf(CityId from, CityId to) {
+    auto& edges = adjList[from];
+    if (edges.empty()) return;
+    for (auto it = edges.begin(); it != edges.end(); ) {
+        if (it->dest == to) it = edges.erase(it);
+        else ++it;
+    }
+    if (edges.empty()) cityCount--;
 }
 
 void Graph::addEdge(string u, string v, int w) {
-    string lu = toLower(u);
-    string lv = toLower(v);
-    
-    string keyU = lowerToOriginal.count(lu) ? lowerToOriginal[lu] : u;
-    string keyV = lowerToOriginal.count(lv) ? lowerToOriginal[lv] : v;
-    
-    lowerToOriginal[lu] = keyU;
-    lowerToOriginal[lv] = keyV;
-    
     if (hasEdge(u, v)) removeEdge(u, v);
-    
-    adjList[keyU].push_back({keyV, w});
-    adjList[keyV].push_back({keyU, w});
+
+    CityId idU = intern(u);
+    CityId idV = intern(v);
+
+    if (adjList[idU].empty()) cityCount++;
+    adjList[idU].push_back({idV, w});
+    if (adjList[idV].empty()) cityCount++;
+    adjList[idV].push_back({idU, w});
+    mergeComponents(idU, idV);
+    touch();
+}
+
+size_t Graph::bulkLoad(const vector<string>& sources, const vector<string>& destinations,
+                       const vector<int>& weights) {
+    size_t n = min({sources.size(), destinations.size(), weights.size()});
+    if (n == 0) return 0;
+
+    // At most two new names per row
+    materialize();
+    size_t before = names.size(), most = before + 2 * n;
+    index.reserve(most);
+    names.reserve(most);
+    adjList.reserve(most);
+    latitude.edit().reserve(most);
+    longitude.edit().reserve(most);
+    comp.reserve(most);
+    members.reserve(most);
+    compDirty.reserve(most);
+
+    // (smaller id, larger id) packed into one key, tagged with its row;
+    // a row naming the same city twice is not a route and is skipped
+    vector<pair<uint64_t, uint32_t>> keyed;
+    keyed.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t a = intern(sources[i]), b = intern(destinations[i]);
+        if (a == b) continue;
+        if (a > b) swap(a, b);
+        keyed.push_back({(a << 32) | b, (uint32_t)i});
+    }
+
+    // Sorting by (key, row) leaves each pair's last row at the end of its run
+    sort(keyed.begin(), keyed.end());
+    size_t unique = 0;
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        if (i + 1 < keyed.size() && keyed[i + 1].first == keyed[i].first) continue;
+        keyed[unique++] = keyed[i];
+    }
+    keyed.resize(unique);
+
+    // Routes the batch replaces are dropped from lists that existed before it
+    auto inBatch = [&](CityId a, CityId b) {
+        if (a > b) swap(a, b);
+        uint64_t key = ((uint64_t)a << 32) | b;
+        auto it = lower_bound(keyed.begin(), keyed.end(), make_pair(key, (uint32_t)0));
+        return it != keyed.end() && it->first == key;
+    };
+    vector<uint32_t> degree(names.size(), 0);
+    for (const auto& [key, row] : keyed) {
+        degree[key >> 32]++;
+        degree[key & UINT32_MAX]++;
+    }
+    for (CityId u = 0; u < before; ++u) {
+        auto& edges = adjList[u];
+        if (degree[u] == 0 || edges.empty()) continue;
+        edges.erase(remove_if(edges.begin(), edges.end(),
+                              [&](const Edge& e) { return inBatch(u, e.dest); }),
+                    edges.end());
+        if (edges.empty()) cityCount--;
+    }
+
+    for (CityId u = 0; u < names.size(); ++u) {
+        if (degree[u] == 0) continue;
+        if (adjList[u].empty()) cityCount++;
+        adjList[u].reserve(adjList[u].size() + degree[u]);
+    }
+    for (const auto& [key, row] : keyed) {
+        CityId a = key >> 32, b = key & UINT32_MAX;
+        int w = weights[row];
+        adjList[a].push_back({b, w});
+        adjList[b].push_back({a, w});
+        mergeComponents(a, b);
+    }
+    touch();
+    return unique;
 }
 
 bool Graph::updateEdge(string u, string v, int w) {
-    string lu = toLower(u);
-    string lv = toLower(v);
-    
-    if (!lowerToOriginal.count(lu) || !lowerToOriginal.count(lv)) return false;
-    
-    string keyU = lowerToOriginal[lu];
-    string keyV = lowerToOriginal[lv];
-    
     if (!hasEdge(u, v)) return false;
-    
+    materialize();
+
+    CityId idU = findCity(u);
+    CityId idV = findCity(v);
+
     // Update weight in u's list
-    for (auto& edge : adjList[keyU]) {
-        if (edge.dest == keyV) {
+    for (auto& edge : adjList[idU]) {
+        if (edge.dest == idV) {
             edge.weight = w;
             break;
         }
     }
-    
+
     // Update weight in v's list
-    for (auto& edge : adjList[keyV]) {
-        if (edge.dest == keyU) {
+    for (auto& edge : adjList[idV]) {
+        if (edge.dest == idU) {
             edge.weight = w;
             break;
         }
     }
+    touch();
     return true;
 }
 
 void Graph::removeEdge(string u, string v) {
-    string lu = toLower(u);
-    string lv = toLower(v);
-    
-    if (!lowerToOriginal.count(lu) || !lowerToOriginal.count(lv)) return;
-    
-    string keyU = lowerToOriginal[lu];
-    string keyV = lowerToOriginal[lv];
-    
-    if (adjList.count(keyU)) {
-        auto& edges = adjList[keyU];
-        for (auto it = edges.begin(); it != edges.end(); ) {
-            if (it->dest == keyV) it = edges.erase(it);
-            else ++it;
-        }
-        if (edges.empty()) {
-            adjList.erase(keyU);
-        }
-    }
-    if (adjList.count(keyV)) {
-        auto& edges = adjList[keyV];
-        for (auto it = edges.begin(); it != edges.end(); ) {
-            if (it->dest == keyU) it = edges.erase(it);
-            else ++it;
-        }
-        if (edges.empty()) {
-            adjList.erase(keyV);
-        }
-    }
+    CityId idU = findCity(u);
+    CityId idV = findCity(v);
+    if (idU == NO_CITY || idV == NO_CITY) return;
+
+    materialize();
+    eraseHalf(idU, idV);
+    eraseHalf(idV, idU);
+    compDirty[comp[idU]] = 1;
+    touch();
 }
 
-bool Graph::hasEdge(string u, string v) {
-    string lu = toLower(u);
-    string lv = toLower(v);
-    
-    if (!lowerToOriginal.count(lu) || !lowerToOriginal.count(lv)) return false;
-    
-    string keyU = lowerToOriginal[lu];
-    string keyV = lowerToOriginal[lv];
-    
-    if (adjList.find(keyU) == adjList.end()) return false;
-    for (const auto& e : adjList[keyU]) {
-        if (e.dest == keyV) return true;
-    }
-    return false;
+bool Graph::hasEdge(string u, string v) const {
+    CityId idU = findCity(u);
+    CityId idV = findCity(v);
+    if (idU == NO_CITY || idV == NO_CITY) return false;
+
+    bool found = false;
+    forEachRoute(idU, [&](const Edge& e) { found = found || e.dest == idV; });
+    return found;
 }
 
-vector<Edge> Graph::getNeighbors(string u) {
-    string lu = toLower(u);
-    if (!lowerToOriginal.count(lu)) return {};
-    
-    string keyU = lowerToOriginal[lu];
-    if (adjList.find(keyU) != adjList.end()) return adjList[keyU];
-    return {};
+NeighborRange Graph::getNeighbors(const string& u) {
+    CityId id = findCity(u);
+    if (id == NO_CITY) return NeighborRange();
+    return snapshot().neighbors(id);
 }
 
 vector<string> Graph::getNodes() {
     vector<string> nodes;
-    for (const auto& pair : adjList) {
-        nodes.push_back(pair.first);
+    for (CityId id = 0; id < names.size(); ++id) {
+        if (degreeOf(id) > 0) nodes.emplace_back(names[id]);
     }
+    sort(nodes.begin(), nodes.end());
     return nodes;
 }
 
 void Graph::clear() {
+    names.clear();
+    index.clear();
+    latitude.rebuild();
+    longitude.rebuild();
     adjList.clear();
-    lowerToOriginal.clear();
+    mapped = false;
+    comp.clear();
+    members.clear();
+    compDirty.clear();
+    cityCount = 0;
+    touch();
 }
 
 int Graph::getCityCount() {
-    return adjList.size();
+    return cityCount;
 }
 
 vector<tuple<int, string, string>> Graph::getAllEdges() {
     vector<tuple<int, string, string>> edges;
-    
-    for (const auto& pair : adjList) {
-        string u = pair.first;
-        for (const auto& e : pair.second) {
-            if (u < e.dest) {
-                edges.push_back(make_tuple(e.weight, u, e.dest));
+
+    for (CityId u = 0; u < names.size(); ++u) {
+        forEachRoute(u, [&](const Edge& e) {
+            if (names[u] < names[e.dest]) {
+                edges.emplace_back(e.weight, string(names[u]), string(names[e.dest]));
             }
-        }
+        });
     }
     return edges;
 }
+
+void Graph::setLocation(string_view city, double lat, double lon) {
+    CityId id = intern(city);
+    latitude.edit()[id] = lat;
+    longitude.edit()[id] = lon;
+    touch();
+}
+
+const CSRGraph& Graph::snapshot() {
+    if (!csrDirty) return csr;
+
+    size_t n = names.size();
+    vector<uint32_t>& offsets = csr.offsets.rebuild();
+    offsets.assign(n + 1, 0);
+    for (CityId u = 0; u < n; ++u) {
+        offsets[u + 1] = offsets[u] + adjList[u].size();
+    }
+
+    vector<CityId>& targets = csr.targets.rebuild();
+    vector<int>& weights = csr.weights.rebuild();
+    targets.resize(offsets[n]);
+    weights.resize(offsets[n]);
+    csr.maxWeight = 0;
+    for (CityId u = 0; u < n; ++u) {
+        uint32_t pos = offsets[u];
+        for (const auto& e : adjList[u]) {
+            targets[pos] = e.dest;
+            weights[pos] = e.weight;
+            if (e.weight > csr.maxWeight) csr.maxWeight = e.weight;
+            pos++;
+        }
+    }
+
+    csr.latitude = latitude;
+    csr.longitude = longitude;
+    csr.fullyLocated = true;
+    double scale = INFINITY;
+    for (CityId u = 0; u < n; ++u) {
+        if (adjList[u].empty()) continue;
+        if (isnan(latitude[u])) {
+            csr.fullyLocated = false;
+            break;
+        }
+        for (const auto& e : adjList[u]) {
+            double km = greatCircleKm(latitude[u], longitude[u], latitude[e.dest], longitude[e.dest]);
+            if (km > 0 && e.weight / km < scale) scale = e.weight / km;
+        }
+    }
+    // Shave a little off so rounding in the haversine never makes it inadmissible
+    csr.unitsPerKm = (csr.fullyLocated && scale != INFINITY) ? scale * (1 - 1e-9) : 0.0;
+
+    csrDirty = false;
+    return csr;
+}
@@ -0,0 +1,391 @@
+#include "../include/GraphSnapshot.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'P', 'F', 'G', 'R', 'A', 'P', 'H', '\0'};
+const uint32_t ENDIAN_TAG = 0x01020304;
+const size_t ALIGN = 64;
+
+enum SectionId : uint32_t {
+    META = 1,
+    NAME_OFFSETS,
+    NAME_BYTES,
+    KEY_OFFSETS,
+    KEY_BYTES,
+    INDEX_SLOTS,
+    CSR_OFFSETS,
+    CSR_TARGETS,
+    CSR_WEIGHTS,
+    LATITUDE,
+    LONGITUDE,
+    COMPONENTS,
+    LANDMARK_CITIES,
+    LANDMARK_TABLES,
+    SPANNING_FOREST,
+    SECTION_LIMIT
+};
+
+struct Header {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t endianTag;
+    uint64_t fileSize;
+    uint64_t checksum;      // over every byte after the header
+    uint32_t sectionCount;
+    uint32_t reserved[7];
+};
+static_assert(sizeof(Header) == 64, "snapshot header must stay 64 bytes");
+
+struct Section {
+    uint32_t id;
+    uint32_t elemSize;
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct Meta {
+    uint64_t names;
+    uint64_t indexCount;
+    int32_t cityCount;
+    int32_t maxWeight;
+    double unitsPerKm;
+    uint32_t fullyLocated;
+    uint32_t landmarkCount;
+};
+
+// Word-at-a-time hash; fed in pieces it gives the same digest as in one go
+class Checksum {
+    uint64_t h = 0x243F6A8885A308D3ULL;
+    uint64_t total = 0;
+    unsigned char tail[8];
+    size_t tailSize = 0;
+
+    void mix(uint64_t w) {
+        h ^= w * 0x9E3779B97F4A7C15ULL;
+        h = ((h << 29) | (h >> 35)) * 0xBF58476D1CE4E5B9ULL;
+    }
+
+public:
+    void update(const void* data, size_t n) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        total += n;
+        while (tailSize && n) {
+            tail[tailSize++] = *p++;
+            n--;
+            if (tailSize == 8) {
+                uint64_t w;
+                memcpy(&w, tail, 8);
+                mix(w);
+                tailSize = 0;
+            }
+        }
+        for (; n >= 8; p += 8, n -= 8) {
+            uint64_t w;
+            memcpy(&w, p, 8);
+            mix(w);
+        }
+        memcpy(tail, p, n);
+        tailSize = n;
+    }
+
+    uint64_t digest() const {
+        Checksum last = *this;
+        uint64_t w = 0;
+        memcpy(&w, tail, tailSize);
+        last.mix(w ^ total);
+        uint64_t d = last.h;
+        d ^= d >> 31;
+        d *= 0x94D049BB133111EBULL;
+        return d ^ (d >> 29);
+    }
+};
+
+struct Piece {
+    uint32_t id;
+    uint32_t elemSize;
+    const void* data;
+    uint64_t count;
+};
+
+template <typename T>
+Piece piece(uint32_t id, const T* data, size_t count) {
+    return {id, (uint32_t)sizeof(T), data, count};
+}
+
+size_t aligned(size_t n) { return (n + ALIGN - 1) / ALIGN * ALIGN; }
+
+} // namespace
+
+bool GraphSnapshot::write(const string& path, Graph& g, const Landmarks& landmarks,
+                          const vector<MSTEdge>& forest, string& error) {
+    g.freeze();
+    const CSRGraph& csr = g.snapshot();
+    size_t n = g.names.size();
+
+    Meta meta = {};
+    meta.names = n;
+    meta.indexCount = g.index.count;
+    meta.cityCount = g.cityCount;
+    meta.maxWeight = csr.maxWeight;
+    meta.unitsPerKm = csr.unitsPerKm;
+    meta.fullyLocated = csr.fullyLocated;
+    meta.landmarkCount = landmarks.landmarks.size();
+
+    // An empty graph has no offset arrays yet; store the single 0 they imply
+    static const uint64_t noNames = 0;
+    static const uint32_t noRoutes = 0;
+    const StringTable& names = g.names;
+    const StringTable& keys = g.index.folded;
+
+    vector<Piece> pieces = {
+        piece(META, &meta, 1),
+        n ? piece(NAME_OFFSETS, names.offsets.data(), n + 1) : piece(NAME_OFFSETS, &noNames, 1),
+        piece(NAME_BYTES, names.bytes.data(), names.bytes.size()),
+        n ? piece(KEY_OFFSETS, keys.offsets.data(), n + 1) : piece(KEY_OFFSETS, &noNames, 1),
+        piece(KEY_BYTES, keys.bytes.data(), keys.bytes.size()),
+        piece(INDEX_SLOTS, g.index.slots.data(), g.index.slots.size()),
+        n ? piece(CSR_OFFSETS, csr.offsets.data(), n + 1) : piece(CSR_OFFSETS, &noRoutes, 1),
+        piece(CSR_TARGETS, csr.targets.data(), csr.targets.size()),
+        piece(CSR_WEIGHTS, csr.weights.data(), csr.weights.size()),
+        piece(LATITUDE, csr.latitude.data(), n),
+        piece(LONGITUDE, csr.longitude.data(), n),
+        piece(COMPONENTS, g.comp.data(), n),
+        piece(LANDMARK_CITIES, landmarks.landmarks.data(), landmarks.landmarks.size()),
+        piece(LANDMARK_TABLES, landmarks.tables.data(), landmarks.tables.size()),
+        piece(SPANNING_FOREST, forest.data(), forest.size()),
+    };
+
+    vector<Section> table;
+    size_t offset = aligned(sizeof(Header) + pieces.size() * sizeof(Section));
+    for (const Piece& p : pieces) {
+        table.push_back({p.id, p.elemSize, offset, p.count});
+        offset = aligned(offset + p.elemSize * p.count);
+    }
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.formatVersion = FORMAT_VERSION;
+    header.endianTag = ENDIAN_TAG;
+    header.fileSize = offset;
+    header.sectionCount = table.size();
+
+    // Same byte stream twice: once hashed, once written
+    static const char zeros[ALIGN] = {};
+    auto emit = [&](auto&& sink) {
+        size_t at = sizeof(Header);
+        sink(table.data(), table.size() * sizeof(Section));
+        at += table.size() * sizeof(Section);
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            sink(zeros, table[i].offset - at);
+            size_t bytes = pieces[i].elemSize * pieces[i].count;
+            if (bytes) sink(pieces[i].data, bytes);
+            at = table[i].offset + bytes;
+        }
+        sink(zeros, header.fileSize - at);
+    };
+    Checksum sum;
+    emit([&](const void* p, size_t n) { sum.update(p, n); });
+    header.checksum = sum.digest();
+
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out) {
+            error = "Cannot write " + tmp;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        emit([&](const void* p, size_t n) { out.write(static_cast<const char*>(p), n); });
+        out.flush();
+        if (!out) {
+            error = "Failed writing " + tmp;
+            remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "Cannot replace " + path;
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GraphSnapshot::read(const string& path, bool verifyChecksum, Graph& g, Landmarks& landmarks,
+                         MappedArray<MSTEdge>& forest, string& error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        close(fd);
+        error = path + " is not a graph snapshot.";
+        return false;
+    }
+    size_t size = st.st_size;
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        error = "Cannot map " + path;
+        return false;
+    }
+    shared_ptr<const void> file(base, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+    const char* bytes = static_cast<const char*>(base);
+
+    const Header& header = *reinterpret_cast<const Header*>(bytes);
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + " is not a graph snapshot.";
+        return false;
+    }
+    if (header.endianTag != ENDIAN_TAG) {
+        error = path + " was written on a machine with a different byte order.";
+        return false;
+    }
+    if (header.formatVersion != FORMAT_VERSION) {
+        error = path + " uses snapshot format " + to_string(header.formatVersion) +
+                "; this build reads format " + to_string(FORMAT_VERSION) + ".";
+        return false;
+    }
+    if (header.fileSize != size ||
+        header.sectionCount > (size - sizeof(Header)) / sizeof(Section)) {
+        error = path + " is truncated.";
+        return false;
+    }
+    if (verifyChecksum) {
+        Checksum sum;
+        sum.update(bytes + sizeof(Header), size - sizeof(Header));
+        if (sum.digest() != header.checksum) {
+            error = path + " failed its checksum.";
+            return false;
+        }
+    }
+
+    // Locate every section, checking it lies inside the file
+    const Section* table = reinterpret_cast<const Section*>(bytes + sizeof(Header));
+    const Section* found[SECTION_LIMIT] = {};
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        const Section& s = table[i];
+        if (s.id == 0 || s.id >= SECTION_LIMIT) continue;   // from a newer writer
+        if (s.offset % ALIGN != 0 || s.offset > size || s.elemSize == 0 ||
+            s.count > (size - s.offset) / s.elemSize) {
+            error = path + " has a corrupt section table.";
+            return false;
+        }
+        found[s.id] = &s;
+    }
+    auto view = [&](SectionId id, auto* type, size_t expected) -> decltype(type) {
+        const Section* s = found[id];
+        typedef typename remove_pointer<decltype(type)>::type T;
+        if (!s || s->elemSize != sizeof(T) || (expected != SIZE_MAX && s->count != expected)) return nullptr;
+        return reinterpret_cast<decltype(type)>(bytes + s->offset);
+    };
+    auto count = [&](SectionId id) { return found[id] ? found[id]->count : 0; };
+
+    const Meta* meta = view(META, (const Meta*)nullptr, 1);
+    if (!meta) {
+        error = path + " has no network description.";
+        return false;
+    }
+    size_t n = meta->names, k = meta->landmarkCount;
+    const uint64_t* nameOffsets = view(NAME_OFFSETS, (const uint64_t*)nullptr, n + 1);
+    const char* nameBytes = view(NAME_BYTES, (const char*)nullptr, SIZE_MAX);
+    const uint64_t* keyOffsets = view(KEY_OFFSETS, (const uint64_t*)nullptr, n + 1);
+    const char* keyBytes = view(KEY_BYTES, (const char*)nullptr, SIZE_MAX);
+    const CityIndex::Slot* slots = view(INDEX_SLOTS, (const CityIndex::Slot*)nullptr, SIZE_MAX);
+    const uint32_t* offsets = view(CSR_OFFSETS, (const uint32_t*)nullptr, n + 1);
+    const CityId* targets = view(CSR_TARGETS, (const CityId*)nullptr, SIZE_MAX);
+    const int* weights = view(CSR_WEIGHTS, (const int*)nullptr, count(CSR_TARGETS));
+    const double* lat = view(LATITUDE, (const double*)nullptr, n);
+    const double* lon = view(LONGITUDE, (const double*)nullptr, n);
+    const CityId* comp = view(COMPONENTS, (const CityId*)nullptr, n);
+    const CityId* marks = view(LANDMARK_CITIES, (const CityId*)nullptr, k);
+    const int* tables = view(LANDMARK_TABLES, (const int*)nullptr, n * k);
+    const MSTEdge* trees = view(SPANNING_FOREST, (const MSTEdge*)nullptr, SIZE_MAX);
+    size_t slotCount = count(INDEX_SLOTS);
+    if (!nameOffsets || !nameBytes || !keyOffsets || !keyBytes || !slots || !offsets ||
+        !targets || !weights || !lat || !lon || !comp || !marks || !tables || !trees ||
+        nameOffsets[n] != count(NAME_BYTES) || keyOffsets[n] != count(KEY_BYTES) ||
+        offsets[n] != count(CSR_TARGETS) || meta->indexCount != n ||
+        (slotCount & (slotCount - 1)) != 0 || n * 4 > slotCount * 3) {
+        error = path + " is missing or has inconsistent sections.";
+        return false;
+    }
+
+    // Every offset must be in order and every stored id must name a city:
+    // they are used as indices, and without the checksum nothing else has
+    // vouched for them
+    size_t edges = count(CSR_TARGETS);
+    bool sane = offsets[0] == 0 && nameOffsets[0] == 0 && keyOffsets[0] == 0 &&
+                meta->cityCount >= 0 && (size_t)meta->cityCount <= n;
+    for (size_t i = 0; sane && i < n; ++i) {
+        sane = offsets[i] <= offsets[i + 1] && nameOffsets[i] <= nameOffsets[i + 1] &&
+               keyOffsets[i] <= keyOffsets[i + 1] && comp[i] < n;
+    }
+    for (size_t i = 0; sane && i < edges; ++i) {
+        sane = targets[i] < n && weights[i] >= 0 && weights[i] <= meta->maxWeight;
+    }
+    // Lookups probe until an EMPTY slot, so the table must hold exactly n
+    // names at CityIndex's load factor, which leaves a quarter of it EMPTY
+    size_t occupied = 0;
+    for (size_t i = 0; sane && i < slotCount; ++i) {
+        sane = slots[i].id == CityIndex::EMPTY || slots[i].id < n;
+        occupied += slots[i].id != CityIndex::EMPTY;
+    }
+    sane = sane && occupied == n;
+    for (size_t i = 0; sane && i < k; ++i) sane = marks[i] < n;
+    for (size_t i = 0; sane && i < count(SPANNING_FOREST); ++i) {
+        sane = trees[i].u < n && trees[i].v < n;
+    }
+    if (!sane) {
+        error = path + " has a corrupt section.";
+        return false;
+    }
+
+    g.clear();
+    if (n) {
+        g.names.offsets.borrow(file, nameOffsets, n + 1);
+        g.names.bytes.borrow(file, nameBytes, count(NAME_BYTES));
+        g.index.folded.offsets.borrow(file, keyOffsets, n + 1);
+        g.index.folded.bytes.borrow(file, keyBytes, count(KEY_BYTES));
+        g.index.slots.borrow(file, slots, slotCount);
+        g.index.count = n;
+    }
+    g.latitude.borrow(file, lat, n);
+    g.longitude.borrow(file, lon, n);
+
+    CSRGraph& csr = g.csr;
+    csr.offsets.borrow(file, offsets, n + 1);
+    csr.targets.borrow(file, targets, edges);
+    csr.weights.borrow(file, weights, edges);
+    csr.latitude = g.latitude;
+    csr.longitude = g.longitude;
+    csr.maxWeight = meta->maxWeight;
+    csr.unitsPerKm = meta->unitsPerKm;
+    csr.fullyLocated = meta->fullyLocated;
+    g.csrDirty = false;
+    g.mapped = true;
+    g.cityCount = meta->cityCount;
+
+    // Member lists are the one thing rebuilt: a single pass over the labels
+    g.comp.assign(comp, comp + n);
+    g.members.assign(n, {});
+    g.compDirty.assign(n, 0);
+    for (CityId id = 0; id < n; ++id) g.members[comp[id]].push_back(id);
+
+    landmarks.landmarks.assign(marks, marks + k);
+    landmarks.tables.borrow(file, tables, n * k);
+    forest.borrow(file, trees, count(SPANNING_FOREST));
+    return true;
+}
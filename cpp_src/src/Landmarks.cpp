@@ -0,0 +1,72 @@
+#include "../include/Landmarks.h"
+#include "../include/PriorityQueues.h"
+#include <climits>
+
+// Fills dist with single-source distances from `source`
+static void distancesFrom(const CSRGraph& csr, CityId source, vector<int>& dist) {
+    dist.assign(csr.numCities(), INT_MAX);
+    FourAryHeap pq;
+    pq.reset(csr.numCities(), csr.maxWeight);
+    dist[source] = 0;
+    pq.push(source, 0);
+
+    while (!pq.empty()) {
+        PQNode top = pq.pop();
+        for (const Edge& e : csr.neighbors(top.city)) {
+            int nd = top.weight + e.weight;
+            if (nd < dist[e.dest]) {
+                dist[e.dest] = nd;
+                pq.push(e.dest, nd);
+            }
+        }
+    }
+}
+
+void Landmarks::build(const CSRGraph& csr, int k) {
+    size_t n = csr.numCities();
+    landmarks.clear();
+    tables.rebuild();
+
+    // Farthest selection: each new landmark maximises its distance to the
+    // ones already chosen, starting from the city farthest from an arbitrary
+    // seed. Unreachable cities count as infinitely far, so every component
+    // gets a landmark before any component gets a second.
+    vector<int> nearest(n, INT_MAX);
+    vector<vector<int>> columns;
+    CityId seed = NO_CITY;
+    for (CityId v = 0; v < n && seed == NO_CITY; ++v) {
+        if (csr.degree(v) > 0) seed = v;
+    }
+    if (seed == NO_CITY || k <= 0) return;
+
+    vector<int> fromSeed;
+    distancesFrom(csr, seed, fromSeed);
+    CityId next = seed;
+    for (CityId v = 0; v < n; ++v) {
+        if (fromSeed[v] != INT_MAX && fromSeed[v] > fromSeed[next]) next = v;
+    }
+
+    while (next != NO_CITY && (int)landmarks.size() < k) {
+        landmarks.push_back(next);
+        columns.emplace_back();
+        distancesFrom(csr, next, columns.back());
+
+        const vector<int>& d = columns.back();
+        next = NO_CITY;
+        int farthest = 0;
+        for (CityId v = 0; v < n; ++v) {
+            if (d[v] < nearest[v]) nearest[v] = d[v];
+            if (csr.degree(v) > 0 && nearest[v] > farthest) {
+                farthest = nearest[v];
+                next = v;
+            }
+        }
+    }
+
+    size_t k2 = landmarks.size();
+    vector<int>& table = tables.rebuild();
+    table.assign(n * k2, INT_MAX);
+    for (size_t i = 0; i < k2; ++i) {
+        for (CityId v = 0; v < n; ++v) table[v * k2 + i] = columns[i][v];
+    }
+}
@@ -1,71 +1,304 @@
 #include "../include/LongestPath.h"
-#include <map>
+#include "../include/SearchWorkspace.h"
+#include "../include/ShortestPath.h"
+#include "../include/WorkerPool.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <mutex>
+#include <thread>
 
-void LongestPath::dfsLongest(Graph& g, string current, string end, 
-                             map<string, bool>& visited, vector<string>& currentPath,
-                             int currentDist, vector<string>& bestPath, int& maxDist) {
-    if (current == end) {
-        if (currentDist > maxDist) {
-            maxDist = currentDist;
-            bestPath = currentPath;
+// Longest path from `start` over exactly the cities in `mask`, ending at each city.
+// dp[mask][v] is -1 when no such path exists; `end` is never extended, since a
+// path may only finish there.
+void LongestPath::bitmaskDP(const CSRGraph& csr, const vector<CityId>& component,
+                            CityId start, CityId end, vector<CityId>& bestPath, int& maxDist) {
+    // The workspace maps each member to its local index, stored as its distance
+    int n = component.size();
+    SearchWorkspace& local = SearchWorkspace::local();
+    local.begin(csr.numCities());
+    for (int i = 0; i < n; ++i) local.set(component[i], i, NO_CITY);
+    int s = local.dist(start), t = local.dist(end);
+
+    // w[u * n + v]: route weight, -1 for no route (heaviest of any duplicates)
+    vector<int> w((size_t)n * n, -1);
+    for (int u = 0; u < n; ++u) {
+        for (const Edge& e : csr.neighbors(component[u])) {
+            int& slot = w[u * n + local.dist(e.dest)];
+            slot = max(slot, e.weight);
+        }
+    }
+
+    size_t states = (size_t)1 << n;
+    vector<int> dp(states * n, -1);
+    dp[((size_t)1 << s) * n + s] = 0;
+    for (size_t mask = 1; mask < states; ++mask) {
+        if (!((mask >> s) & 1)) continue;
+        for (int v = 0; v < n; ++v) {
+            int here = dp[mask * n + v];
+            if (here < 0 || v == t) continue;
+            for (int u = 0; u < n; ++u) {
+                if (((mask >> u) & 1) || w[v * n + u] < 0) continue;
+                int& next = dp[(mask | ((size_t)1 << u)) * n + u];
+                next = max(next, here + w[v * n + u]);
+            }
+        }
+    }
+
+    size_t bestMask = 0;
+    for (size_t mask = 1; mask < states; ++mask) {
+        if (dp[mask * n + t] > maxDist) {
+            maxDist = dp[mask * n + t];
+            bestMask = mask;
         }
-        return;
     }
-    
-    for (const auto& edge : g.getNeighbors(current)) {
-        if (!visited[edge.dest]) {
-            visited[edge.dest] = true;
-            currentPath.push_back(edge.dest);
-            
-            dfsLongest(g, edge.dest, end, visited, currentPath, 
-                      currentDist + edge.weight, bestPath, maxDist);
-            
-            currentPath.pop_back();
-            visited[edge.dest] = false;
+    if (bestMask == 0) return;
+
+    // Walk back through predecessors whose value accounts for the step
+    bestPath.clear();
+    size_t mask = bestMask;
+    int v = t;
+    while (v != s) {
+        bestPath.push_back(component[v]);
+        size_t prev = mask ^ ((size_t)1 << v);
+        for (int u = 0; u < n; ++u) {
+            if (((prev >> u) & 1) && w[u * n + v] >= 0 && dp[prev * n + u] >= 0 &&
+                dp[prev * n + u] + w[u * n + v] == dp[mask * n + v]) {
+                v = u;
+                break;
+            }
         }
+        mask = prev;
     }
+    bestPath.push_back(start);
+    reverse(bestPath.begin(), bestPath.end());
 }
 
-LongestPathResult LongestPath::find(Graph& g, string start, string end) {
+// --- Parallel branch and bound over simple paths ---
+namespace {
+
+class PathSearch {
+public:
+    PathSearch(const CSRGraph& csr, CityId start, CityId end,
+               chrono::steady_clock::time_point deadline, long nodeBudget)
+        : csr(csr), start(start), end(end), deadline(deadline), nodeBudget(nodeBudget),
+          heaviest(csr.numCities(), 0) {
+        for (CityId u = 0; u < csr.numCities(); ++u) {
+            for (const Edge& e : csr.neighbors(u)) heaviest[u] = max(heaviest[u], e.weight);
+        }
+        for (const Edge& e : csr.neighbors(start)) branches.push_back(e);
+        sort(branches.begin(), branches.end(),
+             [](const Edge& a, const Edge& b) { return a.weight > b.weight; });
+    }
+
+    // `path` and `dist` hold an incumbent on entry (dist -1 for none) and the
+    // best path found on return. Returns true if every branch was searched to the end.
+    bool run(vector<CityId>& path, int& dist) {
+        best = dist;
+        bestPath = path;
+        int threads = min<int>(WorkerPool::threadsHere(), branches.size());
+        vector<thread> helpers;
+        for (int i = 1; i < threads; ++i) helpers.emplace_back(&PathSearch::worker, this);
+        worker();
+        for (auto& t : helpers) t.join();
+
+        path = bestPath;
+        dist = best;
+        return !stopped;
+    }
+
+private:
+    // The reachability bound is an O(V + E) BFS, so it is redone only every
+    // this many levels; in between a child inherits its parent's bound
+    static const size_t BOUND_STRIDE = 8;
+
+    // Per-worker state; visited is a bitset over city ids
+    struct Scratch {
+        vector<uint64_t> visited;
+        SearchWorkspace* seen;   // the worker thread's workspace, for the bound's BFS
+        vector<CityId> queue;
+        vector<CityId> path;
+        vector<vector<Edge>> children;   // per depth, heaviest route first
+        long nodes = 0;
+
+        bool isVisited(CityId c) const { return (visited[c >> 6] >> (c & 63)) & 1; }
+        void flip(CityId c) { visited[c >> 6] ^= (uint64_t)1 << (c & 63); }
+    };
+
+    const CSRGraph& csr;
+    CityId start, end;
+    chrono::steady_clock::time_point deadline;
+    long nodeBudget;
+    vector<int> heaviest;   // heaviest route at each city
+    vector<Edge> branches;  // top-level routes out of start, handed out one at a time
+
+    atomic<size_t> nextBranch{0};
+    atomic<long> nodes{0};
+    atomic<bool> stopped{false};
+    atomic<int> best{-1};
+    mutex bestLock;
+    vector<CityId> bestPath;
+
+    void worker() {
+        Scratch s;
+        s.visited.assign((csr.numCities() + 63) / 64, 0);
+        s.seen = &SearchWorkspace::local();
+
+        size_t i;
+        while (!stopped && (i = nextBranch++) < branches.size()) {
+            const Edge& e = branches[i];
+            s.path = {start, e.dest};
+            s.flip(start);
+            s.flip(e.dest);
+            search(s, e.dest, e.weight, INT_MAX);
+            s.flip(e.dest);
+            s.flip(start);
+        }
+    }
+
+    // Each city still to be entered contributes at most its heaviest route, and
+    // only cities reachable from u around the visited ones (and not past the
+    // end city) can be entered. -1 if the end city is cut off.
+    int upperBound(Scratch& s, CityId u) {
+        s.seen->begin(csr.numCities());
+        s.queue.clear();
+        s.queue.push_back(u);
+        s.seen->set(u, 0, NO_CITY);
+
+        int bound = 0;
+        bool reachesEnd = false;
+        for (size_t head = 0; head < s.queue.size(); ++head) {
+            CityId v = s.queue[head];
+            if (v == end) {
+                reachesEnd = true;
+                continue;
+            }
+            for (const Edge& e : csr.neighbors(v)) {
+                if (s.seen->reached(e.dest) || s.isVisited(e.dest)) continue;
+                s.seen->set(e.dest, 0, v);
+                bound += heaviest[e.dest];
+                s.queue.push_back(e.dest);
+            }
+        }
+        return reachesEnd ? bound : -1;
+    }
+
+    bool outOfBudget() {
+        if (chrono::steady_clock::now() >= deadline) stopped = true;
+        return stopped;
+    }
+
+    // `bound` bounds the weight still to be added below u, INT_MAX if unknown
+    void search(Scratch& s, CityId u, int dist, int bound) {
+        if (stopped) return;
+        if (++s.nodes % 1024 == 0) {
+            long total = nodes += 1024;
+            if ((nodeBudget > 0 && total >= nodeBudget) || outOfBudget()) {
+                stopped = true;
+                return;
+            }
+        }
+
+        if (u == end) {
+            if (dist > best) {
+                lock_guard<mutex> guard(bestLock);
+                if (dist > best) {
+                    best = dist;
+                    bestPath = s.path;
+                }
+            }
+            return;
+        }
+
+        // Each city reachable from a child was reachable from u, so a child's
+        // bound is at most u's minus the child's own heaviest route
+        if (bound == INT_MAX || s.path.size() % BOUND_STRIDE == 0) {
+            if (outOfBudget()) return;
+            bound = upperBound(s, u);
+        }
+        if (bound < 0 || dist + bound <= best) return;
+
+        size_t depth = s.path.size();
+        if (s.children.size() <= depth) s.children.resize(depth + 1);
+        vector<Edge>& children = s.children[depth];
+        children.clear();
+        for (const Edge& e : csr.neighbors(u)) {
+            if (!s.isVisited(e.dest)) children.push_back(e);
+        }
+        sort(children.begin(), children.end(),
+             [](const Edge& a, const Edge& b) { return a.weight > b.weight; });
+
+        for (const Edge& e : children) {
+            s.flip(e.dest);
+            s.path.push_back(e.dest);
+            search(s, e.dest, dist + e.weight, bound - heaviest[e.dest]);
+            s.path.pop_back();
+            s.flip(e.dest);
+        }
+    }
+};
+
+}
+
+LongestPathResult LongestPath::find(Graph& g, string start, string end,
+                                    int timeBudgetMs, long nodeBudget) {
     LongestPathResult res;
     res.found = false;
     res.distance = 0;
+    res.provenLongest = false;
 
-    auto nodes = g.getNodes();
-    bool startExists = false, endExists = false;
-    for(const auto& n : nodes) {
-        if(n == start) startExists = true;
-        if(n == end) endExists = true;
-    }
+    CityId s = g.findCity(start);
+    CityId t = g.findCity(end);
 
-    if(!startExists || !endExists) {
+    if(s == NO_CITY || t == NO_CITY) {
         res.message = "One or both cities not found.";
         return res;
     }
 
-    if (start == end) {
+    if (s == t) {
         res.message = "Start and end are the same city.";
         return res;
     }
 
-    map<string, bool> visited;
-    vector<string> currentPath;
-    vector<string> bestPath;
+    // Only the component holding start can contribute to a path
+    const CSRGraph& csr = g.snapshot();
+    bool reachable = g.connected(s, t);
+    const vector<CityId>& component = g.componentMembers(s);
+
+    vector<CityId> bestPath;
     int maxDist = -1;
+    if (!reachable) {
+        res.provenLongest = true;
+    } else if ((int)component.size() <= DP_MAX_CITIES) {
+        bitmaskDP(csr, component, s, t, bestPath, maxDist);
+        res.provenLongest = true;
+    } else {
+        auto deadline = chrono::steady_clock::now() + chrono::milliseconds(max(timeBudgetMs, 0));
 
-    visited[start] = true;
-    currentPath.push_back(start);
+        // Any simple path is a valid incumbent, and the shortest one is one search
+        // away; it keeps a result even when the budget ends the search early
+        vector<CityId> parents;
+        ShortestPath::oneToMany(csr, s, {t}, &maxDist, &parents);
+        for (CityId c = t; c != s; c = parents[c]) bestPath.push_back(c);
+        bestPath.push_back(s);
+        reverse(bestPath.begin(), bestPath.end());
 
-    dfsLongest(g, start, end, visited, currentPath, 0, bestPath, maxDist);
+        PathSearch search(csr, s, t, deadline, nodeBudget);
+        res.provenLongest = search.run(bestPath, maxDist);
+    }
 
     if (maxDist >= 0) {
         res.found = true;
-        res.path = bestPath;
+        for (CityId id : bestPath) res.path.emplace_back(g.getName(id));
         res.distance = maxDist;
-        res.message = "Longest path found.";
+        res.message = res.provenLongest
+            ? "Longest path found."
+            : "Longest path found within the search budget (not proven longest).";
     } else {
-        res.message = "No path found.";
+        res.message = res.provenLongest
+            ? "No path found."
+            : "No path found within the search budget.";
     }
 
     return res;
@@ -1,88 +1,194 @@
 #include "../include/MultiCityTour.h"
-#include <map>
+#include "../include/ShortestPath.h"
+#include "../include/TourSearch.h"
+#include "../include/WorkerPool.h"
+#include <algorithm>
 #include <climits>
+#include <thread>
 
-void MultiCityTour::tspHelper(Graph& g, vector<string>& cities, vector<bool>& visited, 
-                              string current, int count, int cost, int& minCost, 
-                              vector<string>& currentPath, vector<string>& bestPath) {
-    if (count == (int)cities.size()) {
-        if (cost < minCost) {
-            minCost = cost;
-            bestPath = currentPath;
+// Unreachable legs; small enough that adding two of them cannot overflow
+static const int TOUR_INF = INT_MAX / 4;
+
+// Closure search trees kept for leg expansion, in city ids (64 MB)
+static const size_t MAX_KEPT_PARENTS = (size_t)1 << 24;
+
+// Open tour from stop 0 through every stop over the n x n distance table `dist`.
+// dp[mask][j] is the cheapest way to visit `mask` (stops 1..n-1, bit j-1 = stop j)
+// ending at stop j; the visiting order is recovered by walking dp backwards.
+// Returns the stop order, or an empty vector if some stop is unreachable.
+vector<int> MultiCityTour::heldKarp(const vector<int>& dist, int n) {
+    if (n == 1) return {0};
+
+    int m = n - 1;
+    size_t full = ((size_t)1 << m) - 1;
+
+    // into[k][j]: leg from stop j+1 to stop k+1, laid out so the inner loop is contiguous
+    vector<int> into((size_t)m * m);
+    for (int k = 0; k < m; ++k) {
+        for (int j = 0; j < m; ++j) {
+            int d = dist[(j + 1) * n + k + 1];
+            into[k * m + j] = d == INT_MAX ? TOUR_INF : d;
         }
-        return;
     }
 
-    for (size_t i = 0; i < cities.size(); ++i) {
-        if (!visited[i]) {
-            int distToNext = -1;
-            vector<Edge> neighbors = g.getNeighbors(current);
-            for (const auto& edge : neighbors) {
-                if (edge.dest == cities[i]) {
-                    distToNext = edge.weight;
-                    break;
-                }
-            }
+    vector<int> dp((full + 1) * m, TOUR_INF);
+    for (int k = 0; k < m; ++k) {
+        dp[((size_t)1 << k) * m + k] = dist[k + 1] == INT_MAX ? TOUR_INF : dist[k + 1];
+    }
+
+    for (size_t mask = 1; mask <= full; ++mask) {
+        if ((mask & (mask - 1)) == 0) continue;
+        for (int k = 0; k < m; ++k) {
+            if (!((mask >> k) & 1)) continue;
+            // Entries outside `prev` are TOUR_INF, so the min needs no membership test
+            const int* prevRow = &dp[(mask ^ ((size_t)1 << k)) * m];
+            const int* col = &into[k * m];
+            int best = TOUR_INF;
+            for (int j = 0; j < m; ++j) best = min(best, prevRow[j] + col[j]);
+            dp[mask * m + k] = min(best, TOUR_INF);
+        }
+    }
 
-            if (distToNext != -1) {
-                visited[i] = true;
-                currentPath.push_back(cities[i]);
-                
-                tspHelper(g, cities, visited, cities[i], count + 1, 
-                          cost + distToNext, minCost, currentPath, bestPath);
-                
-                currentPath.pop_back();
-                visited[i] = false;
+    int last = 0;
+    for (int j = 1; j < m; ++j) {
+        if (dp[full * m + j] < dp[full * m + last]) last = j;
+    }
+    if (dp[full * m + last] >= TOUR_INF) return {};
+
+    vector<int> order;
+    size_t mask = full;
+    while (true) {
+        order.push_back(last + 1);
+        size_t prev = mask ^ ((size_t)1 << last);
+        if (prev == 0) break;
+        int cost = dp[mask * m + last];
+        for (int k = 0; k < m; ++k) {
+            if (((prev >> k) & 1) && dp[prev * m + k] + into[last * m + k] == cost) {
+                last = k;
+                break;
             }
         }
+        mask = prev;
     }
+    order.push_back(0);
+    return vector<int>(order.rbegin(), order.rend());
 }
 
-TourResult MultiCityTour::plan(Graph& g, vector<string> cities) {
+TourResult MultiCityTour::plan(Graph& g, vector<string> cities, int timeBudgetMs) {
     TourResult res;
     res.found = false;
     res.totalDistance = 0;
+    res.provenOptimal = false;
 
     if (cities.empty()) {
         res.message = "No cities provided.";
         return res;
     }
 
-    // Verify all cities exist
-    vector<string> allNodes = g.getNodes();
+    // Verify all cities exist and translate them to ids; repeated stops collapse
+    vector<CityId> ids;
     for (const auto& city : cities) {
-        bool exists = false;
-        for (const auto& node : allNodes) {
-            if (node == city) {
-                exists = true;
-                break;
-            }
-        }
-        if (!exists) {
+        CityId id = g.findCity(city);
+        if (id == NO_CITY) {
             res.message = "City '" + city + "' not found in graph.";
             return res;
         }
+        bool seen = false;
+        for (CityId other : ids) seen = seen || other == id;
+        if (!seen) ids.push_back(id);
+        if (!g.connected(ids[0], id)) {
+            res.message = "Could not find a path visiting all specified cities.";
+            return res;
+        }
     }
 
-    int minCost = INT_MAX;
-    vector<string> bestPath;
-    vector<string> currentPath;
-    vector<bool> visited(cities.size(), false);
+    int n = ids.size();
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(max(timeBudgetMs, 0));
 
-    // Start from the first city in the list
-    visited[0] = true;
-    currentPath.push_back(cities[0]);
-
-    tspHelper(g, cities, visited, cities[0], 1, 0, minCost, currentPath, bestPath);
+    // Metric closure: shortest-path distance between every pair of stops. The
+    // table is symmetric, so the search from stop i only waits for stops after
+    // it. Its search tree is kept for expanding legs later while the trees fit
+    // in MAX_KEPT_PARENTS ids.
+    const CSRGraph& csr = g.snapshot();
+    vector<int> dist((size_t)n * n, 0);
+    vector<vector<CityId>> trees((size_t)n * csr.numCities() <= MAX_KEPT_PARENTS ? n : 0);
+    vector<int> row(n);
+    int rows = 0;
+    for (int i = 0; i < n; ++i) {
+        if (n > MAX_STOPS && chrono::steady_clock::now() >= deadline) break;
+        vector<CityId> later(ids.begin() + i + 1, ids.end());
+        ShortestPath::oneToMany(csr, ids[i], later, row.data(), trees.empty() ? nullptr : &trees[i]);
+        for (int j = i + 1; j < n; ++j) {
+            dist[(size_t)i * n + j] = dist[(size_t)j * n + i] = row[j - i - 1];
+        }
+        rows = i + 1;
+    }
 
-    if (minCost != INT_MAX) {
+    // Past the budget without a full table, walk to the nearest unvisited stop
+    // each time; every step is one search that stops as soon as it finds one
+    if (rows < n) {
+        vector<char> wanted(csr.numCities(), 0);
+        for (int i = 1; i < n; ++i) wanted[ids[i]] = 1;
+        vector<CityId> route = {ids[0]};
+        CityId at = ids[0];
+        for (int step = 1; step < n; ++step) {
+            int legDist;
+            at = ShortestPath::pathToNearest(csr, at, wanted, route, legDist);
+            wanted[at] = 0;
+            res.totalDistance += legDist;
+        }
         res.found = true;
-        res.path = bestPath;
-        res.totalDistance = minCost;
-        res.message = "Optimal tour planned successfully.";
-    } else {
+        for (CityId id : route) res.path.emplace_back(g.getName(id));
+        res.message = "Tour planned; not proven optimal within the time budget.";
+        return res;
+    }
+
+    // Start from the first city in the list
+    vector<int> order;
+    if (n <= MAX_STOPS) {
+        order = heldKarp(dist, n);
+        res.provenOptimal = true;
+    } else if (find(dist.begin(), dist.begin() + n, INT_MAX) == dist.begin() + n) {
+        // Every stop is reachable from the first, so the whole table is finite
+        order = TourSearch::heuristic(dist, n, deadline);
+        if (timeBudgetMs > 0 && chrono::steady_clock::now() < deadline) {
+            res.provenOptimal = TourSearch::branchAndBound(dist, n, order, deadline,
+                                                           WorkerPool::threadsHere());
+        }
+    }
+    if (order.empty()) {
         res.message = "Could not find a path visiting all specified cities.";
+        return res;
+    }
+
+    // Expand each leg of the tour back into the cities it passes through, from
+    // the closure tree of whichever end was searched first when they were kept
+    vector<CityId> route = {ids[order[0]]};
+    for (int i = 0; i + 1 < n; ++i) {
+        int a = order[i], b = order[i + 1];
+        CityId from = ids[a], to = ids[b];
+        if (trees.empty()) {
+            res.totalDistance += ShortestPath::pathBetween(csr, from, to, route);
+            continue;
+        }
+        res.totalDistance += dist[(size_t)a * n + b];
+        const vector<CityId>& parents = trees[min(a, b)];
+        if (a < b) {
+            size_t legStart = route.size();
+            for (CityId c = to; c != from; c = parents[c]) route.push_back(c);
+            reverse(route.begin() + legStart, route.end());
+        } else {
+            for (CityId c = from; c != to;) {
+                c = parents[c];
+                route.push_back(c);
+            }
+        }
     }
 
+    res.found = true;
+    for (CityId id : route) res.path.emplace_back(g.getName(id));
+    res.message = res.provenOptimal
+        ? "Optimal tour planned successfully."
+        : "Tour planned; not proven optimal within the time budget.";
     return res;
 }
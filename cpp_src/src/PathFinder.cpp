@@ -1,19 +1,131 @@
 #include "../include/PathFinder.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <thread>
 
-OperationResult PathFinder::addCity(string city1, string city2, int distance) {
+// Cache kind for fewest-stops queries; shortest-path kinds are the SearchMode values
+static const uint32_t FEWEST_STOPS_KIND = 0x100;
+
+// City names compare case-insensitively, as the graph's name index does
+static bool sameCity(const string& a, const string& b) {
+    return a.size() == b.size() &&
+           equal(a.begin(), a.end(), b.begin(),
+                 [](char x, char y) { return tolower((unsigned char)x) == tolower((unsigned char)y); });
+}
+
+static bool validLocation(const LatLon& at) {
+    return at.first >= -90.0 && at.first <= 90.0 && at.second >= -180.0 && at.second <= 180.0;
+}
+
+// Derived tables of a version, built once by whichever query gets there first
+static ContractionHierarchy& contractionHierarchy(NetworkVersion& v) {
+    call_once(v.chOnce, [&] { v.ch.reset(new ContractionHierarchy(v.graph.snapshot())); });
+    return *v.ch;
+}
+
+static const Landmarks& landmarksOf(NetworkVersion& v) {
+    call_once(v.landmarkOnce, [&] { v.landmarks.build(v.graph.snapshot(), v.landmarkCount); });
+    return v.landmarks;
+}
+
+static DynamicMST& forestOf(NetworkVersion& v) {
+    if (!v.mstReady) {
+        call_once(v.mstOnce, [&] {
+            if (!v.mst.built()) {
+                if (v.savedForest.empty()) v.mst.build(v.graph);
+                else v.mst.build(v.graph, v.savedForest);
+            }
+            v.mstReady = true;
+        });
+    }
+    return v.mst;
+}
+
+PathFinder::PathFinder() : current(make_shared<NetworkVersion>()) {
+    current->graph.freeze();
+}
+
+shared_ptr<NetworkVersion> PathFinder::pin() {
+    if (hasPending) {
+        lock_guard<mutex> guard(writeLock);
+        if (pending) {
+            pending->graph.freeze();
+            atomic_store(&current, move(pending));
+            pending.reset();
+            hasPending = false;
+        }
+    }
+    return atomic_load(&current);
+}
+
+NetworkVersion& PathFinder::edit() {
+    if (pending) return *pending;
+    const NetworkVersion& old = *current;
+    auto next = make_shared<NetworkVersion>();
+    next->seq = old.seq + 1;
+    next->graph = old.graph;
+    // A forest still being built by a reader is left behind; the next reader rebuilds it
+    if (old.mstReady) {
+        next->mst = old.mst;
+        next->mstReady = true;
+    }
+    next->hotTrees = old.hotTrees;
+    next->landmarkCount = old.landmarkCount;
+    pending = move(next);
+    hasPending = true;
+    return *pending;
+}
+
+OperationResult PathFinder::addCity(string city1, string city2, int distance,
+                                    optional<LatLon> location1, optional<LatLon> location2) {
     OperationResult res;
     if (distance <= 0) {
         res.success = false;
         res.message = "Distance must be positive.";
         return res;
     }
-    
+    if (sameCity(city1, city2)) {
+        res.success = false;
+        res.message = "A route needs two different cities.";
+        return res;
+    }
+    if ((location1 && !validLocation(*location1)) || (location2 && !validLocation(*location2))) {
+        res.success = false;
+        res.message = "Latitude must be within [-90, 90] and longitude within [-180, 180].";
+        return res;
+    }
+
+    lock_guard<mutex> guard(writeLock);
+    NetworkVersion& next = edit();
+    Graph& graph = next.graph;
     graph.addEdge(city1, city2, distance);
+    CityId id1 = graph.findCity(city1), id2 = graph.findCity(city2);
+    next.mst.onRouteSet(graph, id1, id2, distance);
+    next.hotTrees.onRouteSet(graph, id1, id2, distance);
+    if (location1) graph.setLocation(city1, location1->first, location1->second);
+    if (location2) graph.setLocation(city2, location2->first, location2->second);
     res.success = true;
     res.message = "Route added: " + city1 + " <-> " + city2 + " (" + to_string(distance) + " km)";
     return res;
 }
 
+OperationResult PathFinder::setCityLocation(string city, double latitude, double longitude) {
+    OperationResult res;
+    if (!validLocation({latitude, longitude})) {
+        res.success = false;
+        res.message = "Latitude must be within [-90, 90] and longitude within [-180, 180].";
+        return res;
+    }
+
+    lock_guard<mutex> guard(writeLock);
+    NetworkVersion& next = edit();
+    next.graph.setLocation(city, latitude, longitude);
+    res.success = true;
+    res.message = "Location set: " + city + " (" + to_string(latitude) + ", " + to_string(longitude) + ")";
+    return res;
+}
+
 OperationResult PathFinder::updateCity(string city1, string city2, int distance) {
     OperationResult res;
     if (distance <= 0) {
@@ -21,8 +133,15 @@ OperationResult PathFinder::updateCity(string city1, string city2, int distance)
         res.message = "Distance must be positive.";
         return res;
     }
-    
-    if (graph.updateEdge(city1, city2, distance)) {
+
+    lock_guard<mutex> guard(writeLock);
+    if (latest().graph.hasEdge(city1, city2)) {
+        NetworkVersion& next = edit();
+        Graph& graph = next.graph;
+        graph.updateEdge(city1, city2, distance);
+        CityId id1 = graph.findCity(city1), id2 = graph.findCity(city2);
+        next.mst.onRouteSet(graph, id1, id2, distance);
+        next.hotTrees.onRouteSet(graph, id1, id2, distance);
         res.success = true;
         res.message = "Route updated: " + city1 + " <-> " + city2 + " (" + to_string(distance) + " km)";
     } else {
@@ -34,48 +153,338 @@ OperationResult PathFinder::updateCity(string city1, string city2, int distance)
 
 OperationResult PathFinder::removeCity(string city1, string city2) {
     OperationResult res;
-    if (!graph.hasEdge(city1, city2)) {
+    lock_guard<mutex> guard(writeLock);
+    if (!latest().graph.hasEdge(city1, city2)) {
         res.success = false;
         res.message = "Route not found.";
         return res;
     }
-    
+
+    NetworkVersion& next = edit();
+    Graph& graph = next.graph;
+    // Ids first: a city that loses its last route is no longer found by name
+    CityId id1 = graph.findCity(city1), id2 = graph.findCity(city2);
     graph.removeEdge(city1, city2);
+    next.mst.onRouteRemoved(graph, id1, id2);
+    next.hotTrees.onRouteRemoved(graph, id1, id2);
     res.success = true;
     res.message = "Route removed: " + city1 + " <-> " + city2;
     return res;
 }
 
-ShortestPathResult PathFinder::findShortestPath(string start, string end) {
-    return ShortestPath::find(graph, start, end);
+OperationResult PathFinder::loadEdges(const vector<string>& sources,
+                                      const vector<string>& destinations,
+                                      const vector<int>& distances) {
+    OperationResult res;
+    if (sources.size() != destinations.size() || sources.size() != distances.size()) {
+        res.success = false;
+        res.message = "Sources, destinations and distances must have the same length.";
+        return res;
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (distances[i] <= 0) {
+            res.success = false;
+            res.message = "Distance must be positive (row " + to_string(i) + ").";
+            return res;
+        }
+        if (sameCity(sources[i], destinations[i])) {
+            res.success = false;
+            res.message = "A route needs two different cities (row " + to_string(i) + ").";
+            return res;
+        }
+    }
+
+    lock_guard<mutex> guard(writeLock);
+    NetworkVersion& next = edit();
+    size_t routes = next.graph.bulkLoad(sources, destinations, distances);
+    // Too many edits to repair one by one: the forest is rebuilt by the next
+    // query that needs it and the hot trees are rebuilt now
+    next.mst.clear();
+    next.mstReady = false;
+    vector<CityId> hot = next.hotTrees.sources();
+    next.hotTrees.setSources(next.graph, hot);
+    res.success = true;
+    res.message = "Loaded " + to_string(routes) + " routes.";
+    return res;
+}
+
+bool PathFinder::syncCache(uint64_t seq) {
+    if (seq < cacheVersion) return false;
+    if (seq > cacheVersion) {
+        pathCache.clear();
+        stopsCache.clear();
+        treeCache.clear();
+        cacheVersion = seq;
+    }
+    return true;
+}
+
+// Results are cached in ascending id order; a query the other way round gets the path reversed
+template <typename Result>
+static Result oriented(Result res, bool flipped) {
+    if (flipped) reverse(res.path.begin(), res.path.end());
+    return res;
+}
+
+ShortestPathResult PathFinder::findShortestPath(string start, string end, SearchMode mode) {
+    shared_ptr<NetworkVersion> v = pin();
+    Graph& graph = v->graph;
+    CityId s = graph.findCity(start), t = graph.findCity(end);
+    if (s == NO_CITY || t == NO_CITY) return search(*v, start, end, mode);
+
+    ShortestPathResult res;
+    if (v->hotTrees.query(graph, s, t, res)) {
+        cacheTreeHits++;
+        return res;
+    }
+    if (!caching) {
+        cacheMisses++;
+        return search(*v, start, end, mode);
+    }
+
+    QueryKey key = {(uint32_t)mode, min(s, t), max(s, t)};
+    bool flipped = s > t;
+    bool buildTree;
+    {
+        lock_guard<mutex> guard(cacheLock);
+        bool cacheable = syncCache(v->seq);
+        if (ShortestPathResult* hit = cacheable ? pathCache.find(key) : nullptr) {
+            cacheHits++;
+            res = oriented(*hit, flipped);
+            res.settledNodes = 0;
+            return res;
+        }
+        if (ShortestPathTree* tree = cacheable ? treeCache.find(s) : nullptr) {
+            cacheTreeHits++;
+            res = ShortestPath::fromTree(graph, *tree, t);
+            pathCache.put(key, oriented(res, flipped));
+            return res;
+        }
+        if (ShortestPathTree* tree = cacheable ? treeCache.find(t) : nullptr) {
+            cacheTreeHits++;
+            res = oriented(ShortestPath::fromTree(graph, *tree, s), true);
+            pathCache.put(key, oriented(res, flipped));
+            return res;
+        }
+        buildTree = cacheable && treeCache.capacity() > 0;
+    }
+
+    // The search itself runs outside the lock
+    cacheMisses++;
+    ShortestPathTree built;
+    if (buildTree) {
+        ShortestPath::buildTree(graph.snapshot(), s, built);
+        res = ShortestPath::fromTree(graph, built, t);
+        res.settledNodes = count_if(built.dist.begin(), built.dist.end(),
+                                    [](int d) { return d != INT_MAX; });
+    } else {
+        res = search(*v, start, end, mode);
+    }
+
+    lock_guard<mutex> guard(cacheLock);
+    if (syncCache(v->seq)) {
+        if (buildTree) treeCache.put(s, move(built));
+        pathCache.put(key, oriented(res, flipped));
+    }
+    return res;
+}
+
+ShortestPathResult PathFinder::search(NetworkVersion& v, string start, string end, SearchMode mode) {
+    if (mode == SearchMode::Bidirectional) {
+        return ShortestPath::findBidirectional(v.graph, start, end);
+    }
+    if (mode == SearchMode::AStar) {
+        return ShortestPath::findAStar(v.graph, start, end);
+    }
+    if (mode == SearchMode::ALT) {
+        return ShortestPath::findALT(v.graph, landmarksOf(v), start, end);
+    }
+    if (mode == SearchMode::ContractionHierarchy) {
+        return contractionHierarchy(v).query(v.graph, start, end);
+    }
+    return ShortestPath::find(v.graph, start, end);
+}
+
+void PathFinder::prepareContractionHierarchy() {
+    contractionHierarchy(*pin());
+}
+
+OperationResult PathFinder::setLandmarkCount(int k) {
+    OperationResult res;
+    if (k <= 0) {
+        res.success = false;
+        res.message = "Landmark count must be positive.";
+        return res;
+    }
+
+    lock_guard<mutex> guard(writeLock);
+    NetworkVersion& next = edit();
+    next.landmarkCount = k;
+    res.success = true;
+    res.message = "Landmark count set to " + to_string(k) + ".";
+    return res;
+}
+
+void PathFinder::prepareLandmarks() {
+    landmarksOf(*pin());
+}
+
+DistanceMatrix PathFinder::distanceMatrix(vector<string> sources, vector<string> targets) {
+    shared_ptr<NetworkVersion> v = pin();
+    Graph& graph = v->graph;
+    DistanceMatrix res;
+    res.rows = sources.size();
+    res.cols = targets.size();
+    res.distances.assign((size_t)res.rows * res.cols, -1);
+
+    // Names are resolved once for the whole table
+    int unknown = 0;
+    vector<CityId> targetIds;
+    for (const auto& t : targets) {
+        targetIds.push_back(graph.findCity(t));
+        if (targetIds.back() == NO_CITY) unknown++;
+    }
+
+    const CSRGraph& csr = graph.snapshot();
+    vector<int> row(res.cols);
+    for (int i = 0; i < res.rows; ++i) {
+        CityId s = graph.findCity(sources[i]);
+        if (s == NO_CITY) {
+            unknown++;
+            continue;
+        }
+        ShortestPath::oneToMany(csr, s, targetIds, row.data());
+        for (int j = 0; j < res.cols; ++j) {
+            if (row[j] != INT_MAX) res.distances[(size_t)i * res.cols + j] = row[j];
+        }
+    }
+
+    res.message = unknown == 0
+        ? "Distance matrix computed."
+        : "Distance matrix computed; " + to_string(unknown) + " unknown cities left as -1.";
+    return res;
 }
 
-LongestPathResult PathFinder::findLongestPath(string start, string end) {
-    return LongestPath::find(graph, start, end);
+LongestPathResult PathFinder::findLongestPath(string start, string end,
+                                              int timeBudgetMs, long nodeBudget) {
+    return LongestPath::find(pin()->graph, start, end, timeBudgetMs, nodeBudget);
 }
 
 FewestStopsResult PathFinder::findFewestStops(string start, string end) {
-    return FewestStops::find(graph, start, end);
+    shared_ptr<NetworkVersion> v = pin();
+    Graph& graph = v->graph;
+    CityId s = graph.findCity(start), t = graph.findCity(end);
+    if (s == NO_CITY || t == NO_CITY) return FewestStops::find(graph, start, end);
+    if (!caching) {
+        cacheMisses++;
+        return FewestStops::find(graph, start, end);
+    }
+
+    QueryKey key = {FEWEST_STOPS_KIND, min(s, t), max(s, t)};
+    bool flipped = s > t;
+    {
+        lock_guard<mutex> guard(cacheLock);
+        if (syncCache(v->seq)) {
+            if (FewestStopsResult* hit = stopsCache.find(key)) {
+                cacheHits++;
+                return oriented(*hit, flipped);
+            }
+        }
+    }
+
+    cacheMisses++;
+    FewestStopsResult res = FewestStops::find(graph, start, end);
+    lock_guard<mutex> guard(cacheLock);
+    if (syncCache(v->seq)) stopsCache.put(key, oriented(res, flipped));
+    return res;
+}
+
+vector<pair<string, int>> PathFinder::hopCounts(vector<string> sources) {
+    shared_ptr<NetworkVersion> v = pin();
+    Graph& graph = v->graph;
+    vector<CityId> ids;
+    for (const auto& s : sources) {
+        CityId id = graph.findCity(s);
+        if (id != NO_CITY) ids.push_back(id);
+    }
+
+    vector<int> hops;
+    FewestStops::bfs(graph.snapshot(), ids, hops);
+
+    vector<pair<string, int>> result;
+    for (CityId c = 0; c < hops.size(); ++c) {
+        if (hops[c] >= 0) result.emplace_back(graph.getName(c), hops[c]);
+    }
+    sort(result.begin(), result.end(), [](const pair<string, int>& a, const pair<string, int>& b) {
+        return a.second != b.second ? a.second < b.second : a.first < b.first;
+    });
+    return result;
 }
 
 vector<string> PathFinder::findReachableCities(string start) {
-    return ReachableCities::find(graph, start);
+    return ReachableCities::find(pin()->graph, start);
 }
 
-TourResult PathFinder::planMultiCityTour(vector<string> cities) {
-    return MultiCityTour::plan(graph, cities);
+vector<BatchResult> PathFinder::batchQuery(vector<tuple<QueryKind, string, string>> requests,
+                                           SearchMode mode) {
+    vector<BatchResult> results(requests.size());
+
+    // Workers take the next unanswered request until none are left; a request
+    // that throws gets its error as the result instead of ending the process
+    atomic<size_t> next{0};
+    function<void()> worker = [&] {
+        size_t i;
+        while ((i = next++) < requests.size()) {
+            const string& start = get<1>(requests[i]);
+            const string& end = get<2>(requests[i]);
+            BatchResult& out = results[i];
+            try {
+                switch (get<0>(requests[i])) {
+                case QueryKind::ShortestPath: {
+                    ShortestPathResult r = findShortestPath(start, end, mode);
+                    out = {r.found, move(r.path), r.distance, move(r.message)};
+                    break;
+                }
+                case QueryKind::FewestStops: {
+                    FewestStopsResult r = findFewestStops(start, end);
+                    out = {r.found, move(r.path), r.stops, move(r.message)};
+                    break;
+                }
+                case QueryKind::LongestPath: {
+                    LongestPathResult r = findLongestPath(start, end);
+                    out = {r.found, move(r.path), r.distance, move(r.message)};
+                    break;
+                }
+                }
+            } catch (const exception& e) {
+                out = {false, {}, 0, string("Query failed: ") + e.what()};
+            } catch (...) {
+                out = {false, {}, 0, "Query failed."};
+            }
+        }
+    };
+
+    if (requests.size() > 1) workers.run(worker);
+    else worker();
+    return results;
 }
 
-MSTResult PathFinder::findCheapestNetwork() {
-    return CheapestNetwork::find(graph);
+TourResult PathFinder::planMultiCityTour(vector<string> cities, int timeBudgetMs) {
+    return MultiCityTour::plan(pin()->graph, cities, timeBudgetMs);
+}
+
+MSTResult PathFinder::findCheapestNetwork(MSTAlgorithm algorithm) {
+    shared_ptr<NetworkVersion> v = pin();
+    if (algorithm == MSTAlgorithm::Auto) return forestOf(*v).result(v->graph);
+    return CheapestNetwork::find(v->graph, algorithm);
 }
 
 vector<string> PathFinder::getAllCities() {
-    return graph.getNodes();
+    return pin()->graph.getNodes();
 }
 
 vector<tuple<string, string, int>> PathFinder::getAllRoutes() {
-    auto edges = graph.getAllEdges();
+    auto edges = pin()->graph.getAllEdges();
     vector<tuple<string, string, int>> result;
     for (size_t i = 0; i < edges.size(); ++i) {
         const auto& edge = edges[i];
@@ -85,5 +494,141 @@ vector<tuple<string, string, int>> PathFinder::getAllRoutes() {
 }
 
 void PathFinder::clearAll() {
-    graph.clear();
+    {
+        lock_guard<mutex> guard(writeLock);
+        auto next = make_shared<NetworkVersion>();
+        next->seq = current->seq + 1;
+        next->landmarkCount = latest().landmarkCount;
+        pending = move(next);
+        hasPending = true;
+    }
+    clearCache();
+}
+
+OperationResult PathFinder::saveSnapshot(string path) {
+    OperationResult res;
+    shared_ptr<NetworkVersion> v = pin();
+    const Landmarks& landmarks = landmarksOf(*v);
+    vector<MSTEdge> forest = forestOf(*v).edges();
+    string error;
+    if (!GraphSnapshot::write(path, v->graph, landmarks, forest, error)) {
+        res.success = false;
+        res.message = error;
+        return res;
+    }
+    res.success = true;
+    res.message = "Snapshot saved: " + path;
+    return res;
+}
+
+OperationResult PathFinder::openSnapshot(string path, bool verifyChecksum) {
+    OperationResult res;
+    auto next = make_shared<NetworkVersion>();
+    string error;
+    if (!GraphSnapshot::read(path, verifyChecksum, next->graph, next->landmarks,
+                             next->savedForest, error)) {
+        res.success = false;
+        res.message = error;
+        return res;
+    }
+    // The stored tables stand in for the first landmark query's build
+    if (!next->landmarks.empty()) {
+        next->landmarkCount = next->landmarks.count();
+        call_once(next->landmarkOnce, [] {});
+    }
+
+    {
+        lock_guard<mutex> guard(writeLock);
+        next->seq = current->seq + 1;
+        if (next->landmarks.empty()) next->landmarkCount = latest().landmarkCount;
+        pending = move(next);
+        hasPending = true;
+    }
+    clearCache();
+    res.success = true;
+    res.message = "Snapshot opened: " + path;
+    return res;
+}
+
+OperationResult PathFinder::setHotSources(vector<string> cities) {
+    OperationResult res;
+    lock_guard<mutex> guard(writeLock);
+    vector<CityId> ids;
+    for (const auto& c : cities) {
+        CityId id = latest().graph.findCity(c);
+        if (id == NO_CITY) {
+            res.success = false;
+            res.message = "City not found: " + c;
+            return res;
+        }
+        ids.push_back(id);
+    }
+
+    NetworkVersion& next = edit();
+    next.hotTrees.setSources(next.graph, ids);
+    size_t count = next.hotTrees.sources().size();
+    res.success = true;
+    res.message = "Tracking shortest-path trees for " + to_string(count) + " cities.";
+    return res;
+}
+
+vector<string> PathFinder::getHotSources() {
+    shared_ptr<NetworkVersion> v = pin();
+    vector<string> names;
+    for (CityId id : v->hotTrees.sources()) names.emplace_back(v->graph.getName(id));
+    return names;
+}
+
+OperationResult PathFinder::setCacheCapacity(int entries) {
+    OperationResult res;
+    if (entries < 0) {
+        res.success = false;
+        res.message = "Cache capacity must not be negative.";
+        return res;
+    }
+
+    lock_guard<mutex> guard(cacheLock);
+    pathCache.setCapacity(entries);
+    stopsCache.setCapacity(entries);
+    caching = entries > 0 || treeCache.capacity() > 0;
+    res.success = true;
+    res.message = "Result cache capacity set to " + to_string(entries) + ".";
+    return res;
+}
+
+OperationResult PathFinder::setTreeCacheCapacity(int trees) {
+    OperationResult res;
+    if (trees < 0) {
+        res.success = false;
+        res.message = "Tree cache capacity must not be negative.";
+        return res;
+    }
+
+    lock_guard<mutex> guard(cacheLock);
+    treeCache.setCapacity(trees);
+    caching = trees > 0 || pathCache.capacity() > 0;
+    res.success = true;
+    res.message = "Shortest-path tree cache capacity set to " + to_string(trees) + ".";
+    return res;
+}
+
+CacheStats PathFinder::getCacheStats() {
+    uint64_t seq = pin()->seq;
+    lock_guard<mutex> guard(cacheLock);
+    syncCache(seq);
+    CacheStats stats;
+    stats.hits = cacheHits;
+    stats.treeHits = cacheTreeHits;
+    stats.misses = cacheMisses;
+    stats.entries = pathCache.size() + stopsCache.size();
+    stats.trees = treeCache.size();
+    return stats;
+}
+
+void PathFinder::clearCache() {
+    lock_guard<mutex> guard(cacheLock);
+    pathCache.clear();
+    stopsCache.clear();
+    treeCache.clear();
+    cacheHits = cacheTreeHits = cacheMisses = 0;
 }
@@ -1,42 +1,15 @@
 #include "../include/ReachableCities.h"
-#include <map>
 
 vector<string> ReachableCities::find(Graph& g, string start) {
     vector<string> reachable;
     
     // Check if start city exists
-    auto nodes = g.getNodes();
-    bool exists = false;
-    for (const auto& n : nodes) {
-        if (n == start) {
-            exists = true;
-            break;
-        }
-    }
-    if (!exists) return reachable;
-
-    map<string, bool> visited;
-    CustomStack<string> s; // Using Person 1's Stack for DFS
-    s.push(start);
+    CityId s = g.findCity(start);
+    if (s == NO_CITY) return reachable;
 
-    while (!s.empty()) {
-        string u = s.top(); 
-        s.pop();
-        
-        if (!visited[u]) {
-            visited[u] = true;
-            
-            // Add to list if it's not the starting city
-            if (u != start) {
-                reachable.push_back(u);
-            }
-            
-            for (const auto& e : g.getNeighbors(u)) {
-                if (!visited[e.dest]) {
-                    s.push(e.dest);
-                }
-            }
-        }
+    // Graph keeps the component member list, so no traversal is needed
+    for (CityId c : g.componentMembers(s)) {
+        if (c != s) reachable.emplace_back(g.getName(c));
     }
     return reachable;
 }
@@ -1,75 +1,382 @@
 #include "../include/ShortestPath.h"
-#include <map>
+#include "../include/SearchWorkspace.h"
 #include <climits>
+#include <cmath>
 
-ShortestPathResult ShortestPath::find(Graph& g, string start, string end) {
+// Appends the names on the parent chain from `from` to `to`, in order from -> to
+template <typename ParentOf>
+static void appendPath(Graph& g, const ParentOf& parentOf, CityId from, CityId to,
+                       vector<string>& path) {
+    // Reconstruct path using CustomStack; kept per thread so it stays warm
+    static thread_local CustomStack<CityId> pathStack;
+    pathStack.clear();
+    CityId curr = to;
+    while (curr != from) {
+        pathStack.push(curr);
+        curr = parentOf(curr);
+    }
+    pathStack.push(from);
+
+    // Transfer from stack to vector
+    while (!pathStack.empty()) {
+        path.emplace_back(g.getName(pathStack.top()));
+        pathStack.pop();
+    }
+}
+
+// Potential that turns the goal-directed search back into plain Dijkstra
+struct ZeroPotential {
+    int operator()(CityId) const { return 0; }
+};
+
+// Great-circle lower bound on the remaining distance to the target. It is
+// consistent (floor keeps it so for integer weights), which lets A* stop the
+// first time the target is popped.
+struct GreatCirclePotential {
+    const CSRGraph& csr;
+    double targetLat, targetLon;
+
+    GreatCirclePotential(const CSRGraph& csr, CityId t)
+        : csr(csr), targetLat(csr.latitude[t]), targetLon(csr.longitude[t]) {}
+
+    int operator()(CityId v) const {
+        return (int)floor(csr.unitsPerKm *
+                          greatCircleKm(csr.latitude[v], csr.longitude[v], targetLat, targetLon));
+    }
+};
+
+// Landmark (ALT) lower bound towards the target; a max of consistent bounds
+struct LandmarkPotential {
+    const Landmarks& landmarks;
+    CityId target;
+
+    int operator()(CityId v) const { return landmarks.lowerBound(v, target); }
+};
+
+// Dijkstra on reduced costs w(u, v) + pi(v) - pi(u); queue keys are dist + pi
+template <typename Queue, typename Potential>
+static ShortestPathResult search(Graph& g, CityId s, CityId t, const Potential& pi) {
     ShortestPathResult res;
     res.found = false;
     res.distance = 0;
+    res.settledNodes = 0;
 
-    // Check if start and end cities exist in the graph
-    vector<string> allNodes = g.getNodes();
-    bool startExists = false, endExists = false;
-    for (const auto& n : allNodes) {
-        if (n == start) startExists = true;
-        if (n == end) endExists = true;
-    }
-
-    if (!startExists || !endExists) {
-        res.message = "One or both cities not found in the network.";
+    // Different components: no search can succeed
+    if (!g.connected(s, t)) {
+        res.message = "No route exists between these cities.";
         return res;
     }
 
-    map<string, int> dist;
-    map<string, string> parent;
-    for (const auto& city : allNodes) {
-        dist[city] = INT_MAX;
-    }
+    const CSRGraph& csr = g.snapshot();
+    SearchWorkspace& ws = SearchWorkspace::local();
+    ws.begin(csr.numCities());
 
-    MinPQ pq;
-    dist[start] = 0;
-    pq.push(0, start);
+    // One queue per thread, reused so its buffers stay warm across queries
+    static thread_local Queue pq;
+    pq.reset(csr.numCities(), csr.maxWeight);
+    ws.set(s, 0, NO_CITY);
+    pq.push(s, pi(s));
 
     while (!pq.empty()) {
         PQNode top = pq.pop();
-        
-        if (top.weight > dist[top.city]) continue;
-        if (top.city == end) break;
-
-        for (const auto& edge : g.getNeighbors(top.city)) {
-            int newDist = dist[top.city] + edge.weight;
-            
-            if (newDist < dist[edge.dest]) {
-                dist[edge.dest] = newDist;
-                parent[edge.dest] = top.city;
-                pq.push(newDist, edge.dest);
+        CityId u = top.city;
+
+        int du = top.weight - pi(u);
+        if (du > ws.dist(u)) continue;
+        res.settledNodes++;
+        if (u == t) break;
+
+        for (const Edge& e : csr.neighbors(u)) {
+            int newDist = du + e.weight;
+
+            if (newDist < ws.dist(e.dest)) {
+                ws.set(e.dest, newDist, u);
+                pq.push(e.dest, newDist + pi(e.dest));
             }
         }
     }
 
-    if (dist[end] == INT_MAX) {
+    if (!ws.reached(t)) {
         res.message = "No route exists between these cities.";
     } else {
         res.found = true;
-        res.distance = dist[end];
-        
-        // Reconstruct path using CustomStack
-        CustomStack<string> pathStack;
-        string curr = end;
-        while (curr != start) {
-            pathStack.push(curr);
-            curr = parent[curr];
+        res.distance = ws.dist(t);
+        appendPath(g, [&](CityId c) { return ws.parent(c); }, s, t, res.path);
+        res.message = "Shortest path found successfully.";
+    }
+
+    return res;
+}
+
+template <typename Queue>
+ShortestPathResult ShortestPath::find(Graph& g, string start, string end) {
+    // Resolve both cities to dense ids once; the search never touches names
+    CityId s = g.findCity(start);
+    CityId t = g.findCity(end);
+
+    if (s == NO_CITY || t == NO_CITY) {
+        ShortestPathResult res;
+        res.found = false;
+        res.distance = 0;
+        res.settledNodes = 0;
+        res.message = "One or both cities not found in the network.";
+        return res;
+    }
+
+    return search<Queue>(g, s, t, ZeroPotential());
+}
+
+ShortestPathResult ShortestPath::find(Graph& g, string start, string end) {
+    return find<FourAryHeap>(g, start, end);
+}
+
+template ShortestPathResult ShortestPath::find<FourAryHeap>(Graph&, string, string);
+template ShortestPathResult ShortestPath::find<RadixHeap>(Graph&, string, string);
+template ShortestPathResult ShortestPath::find<DialBuckets>(Graph&, string, string);
+
+ShortestPathResult ShortestPath::findBidirectional(Graph& g, string start, string end) {
+    ShortestPathResult res;
+    res.found = false;
+    res.distance = 0;
+    res.settledNodes = 0;
+
+    CityId s = g.findCity(start);
+    CityId t = g.findCity(end);
+
+    if (s == NO_CITY || t == NO_CITY) {
+        res.message = "One or both cities not found in the network.";
+        return res;
+    }
+    if (!g.connected(s, t)) {
+        res.message = "No route exists between these cities.";
+        return res;
+    }
+
+    // Routes are undirected, so the backward search runs on the same snapshot
+    const CSRGraph& csr = g.snapshot();
+    size_t n = csr.numCities();
+    SearchWorkspace* ws[2] = {&SearchWorkspace::local(0), &SearchWorkspace::local(1)};
+    int radius[2] = {0, 0};   // key of the last city settled on each side
+
+    static thread_local FourAryHeap queues[2];
+    for (auto& q : queues) q.reset(n, csr.maxWeight);
+    ws[0]->begin(n);
+    ws[1]->begin(n);
+    ws[0]->set(s, 0, NO_CITY);
+    ws[1]->set(t, 0, NO_CITY);
+    queues[0].push(s, 0);
+    queues[1].push(t, 0);
+
+    // Best s-t distance seen so far through a city reached from both sides
+    int best = (s == t) ? 0 : INT_MAX;
+    CityId meet = (s == t) ? s : NO_CITY;
+
+    while (!queues[0].empty() && !queues[1].empty()) {
+        // Grow whichever ball is currently smaller
+        int side = (radius[0] <= radius[1]) ? 0 : 1;
+        PQNode top = queues[side].pop();
+        CityId u = top.city;
+
+        if (top.weight > ws[side]->dist(u)) continue;
+        radius[side] = top.weight;
+
+        // No path through an unsettled city can beat `best` any more
+        if (best != INT_MAX && radius[0] + radius[1] >= best) break;
+        res.settledNodes++;
+
+        const SearchWorkspace& other = *ws[1 - side];
+        for (const Edge& e : csr.neighbors(u)) {
+            int newDist = top.weight + e.weight;
+
+            if (newDist < ws[side]->dist(e.dest)) {
+                ws[side]->set(e.dest, newDist, u);
+                queues[side].push(e.dest, newDist);
+
+                int rest = other.dist(e.dest);
+                if (rest != INT_MAX && newDist + rest < best) {
+                    best = newDist + rest;
+                    meet = e.dest;
+                }
+            }
+        }
+    }
+
+    if (meet == NO_CITY) {
+        res.message = "No route exists between these cities.";
+        return res;
+    }
+
+    res.found = true;
+    res.distance = best;
+    appendPath(g, [&](CityId c) { return ws[0]->parent(c); }, s, meet, res.path);
+    for (CityId curr = meet; curr != t; ) {
+        curr = ws[1]->parent(curr);
+        res.path.emplace_back(g.getName(curr));
+    }
+    res.message = "Shortest path found successfully.";
+    return res;
+}
+
+ShortestPathResult ShortestPath::findAStar(Graph& g, string start, string end) {
+    CityId s = g.findCity(start);
+    CityId t = g.findCity(end);
+    const CSRGraph& csr = g.snapshot();
+
+    // Without coordinates everywhere the bound is not consistent; use Dijkstra
+    if (s == NO_CITY || t == NO_CITY || !csr.fullyLocated) {
+        return find(g, start, end);
+    }
+
+    // Keys are no longer within maxWeight of each other, so stay on the heap
+    return search<FourAryHeap>(g, s, t, GreatCirclePotential(csr, t));
+}
+
+ShortestPathResult ShortestPath::findALT(Graph& g, const Landmarks& landmarks, string start, string end) {
+    CityId s = g.findCity(start);
+    CityId t = g.findCity(end);
+
+    if (s == NO_CITY || t == NO_CITY || landmarks.empty()) {
+        return find(g, start, end);
+    }
+
+    return search<FourAryHeap>(g, s, t, LandmarkPotential{landmarks, t});
+}
+
+void ShortestPath::oneToMany(const CSRGraph& csr, CityId source, const vector<CityId>& targets,
+                             int* distances, vector<CityId>* parents) {
+    size_t n = csr.numCities();
+    SearchWorkspace& ws = SearchWorkspace::local(0);
+    ws.begin(n);
+
+    // Count distinct targets still waiting to be settled; in the second
+    // workspace a waiting target reads 0 and a settled one 1
+    SearchWorkspace& wanted = SearchWorkspace::local(1);
+    wanted.begin(n);
+    size_t remaining = 0;
+    for (CityId t : targets) {
+        if (t != NO_CITY && !wanted.reached(t)) {
+            wanted.set(t, 0, NO_CITY);
+            remaining++;
         }
-        pathStack.push(start);
+    }
+
+    static thread_local FourAryHeap pq;
+    pq.reset(n, csr.maxWeight);
+    ws.set(source, 0, NO_CITY);
+    pq.push(source, 0);
 
-        // Transfer from stack to vector
-        while (!pathStack.empty()) {
-            res.path.push_back(pathStack.top());
-            pathStack.pop();
+    while (!pq.empty() && remaining > 0) {
+        PQNode top = pq.pop();
+        CityId u = top.city;
+        if (wanted.dist(u) == 0) {
+            wanted.set(u, 1, NO_CITY);
+            remaining--;
         }
-        
-        res.message = "Shortest path found successfully.";
+
+        for (const Edge& e : csr.neighbors(u)) {
+            int newDist = top.weight + e.weight;
+            if (newDist < ws.dist(e.dest)) {
+                ws.set(e.dest, newDist, u);
+                pq.push(e.dest, newDist);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        distances[i] = targets[i] == NO_CITY ? INT_MAX : ws.dist(targets[i]);
+    }
+    if (parents) {
+        parents->resize(n);
+        for (CityId c = 0; c < n; ++c) (*parents)[c] = ws.parent(c);
+    }
+}
+
+int ShortestPath::pathBetween(const CSRGraph& csr, CityId source, CityId target,
+                              vector<CityId>& route) {
+    int d;
+    oneToMany(csr, source, {target}, &d);
+    if (d == INT_MAX) return d;
+
+    // oneToMany leaves its tree in this thread's first workspace
+    SearchWorkspace& ws = SearchWorkspace::local(0);
+    size_t start = route.size();
+    for (CityId c = target; c != source; c = ws.parent(c)) route.push_back(c);
+    reverse(route.begin() + start, route.end());
+    return d;
+}
+
+CityId ShortestPath::pathToNearest(const CSRGraph& csr, CityId source, const vector<char>& wanted,
+                                   vector<CityId>& route, int& distance) {
+    size_t n = csr.numCities();
+    SearchWorkspace& ws = SearchWorkspace::local(0);
+    ws.begin(n);
+
+    static thread_local FourAryHeap pq;
+    pq.reset(n, csr.maxWeight);
+    ws.set(source, 0, NO_CITY);
+    pq.push(source, 0);
+
+    while (!pq.empty()) {
+        PQNode top = pq.pop();
+        CityId u = top.city;
+        if (wanted[u] && u != source) {
+            size_t start = route.size();
+            for (CityId c = u; c != source; c = ws.parent(c)) route.push_back(c);
+            reverse(route.begin() + start, route.end());
+            distance = top.weight;
+            return u;
+        }
+
+        for (const Edge& e : csr.neighbors(u)) {
+            int newDist = top.weight + e.weight;
+            if (newDist < ws.dist(e.dest)) {
+                ws.set(e.dest, newDist, u);
+                pq.push(e.dest, newDist);
+            }
+        }
+    }
+    distance = INT_MAX;
+    return NO_CITY;
+}
+
+void ShortestPath::buildTree(const CSRGraph& csr, CityId source, ShortestPathTree& tree) {
+    size_t n = csr.numCities();
+    tree.source = source;
+    tree.dist.assign(n, INT_MAX);
+    tree.parent.assign(n, NO_CITY);
+
+    static thread_local FourAryHeap pq;
+    pq.reset(n, csr.maxWeight);
+    tree.dist[source] = 0;
+    pq.push(source, 0);
+
+    while (!pq.empty()) {
+        PQNode top = pq.pop();
+        for (const Edge& e : csr.neighbors(top.city)) {
+            int newDist = top.weight + e.weight;
+            if (newDist < tree.dist[e.dest]) {
+                tree.dist[e.dest] = newDist;
+                tree.parent[e.dest] = top.city;
+                pq.push(e.dest, newDist);
+            }
+        }
+    }
+}
+
+ShortestPathResult ShortestPath::fromTree(Graph& g, const ShortestPathTree& tree, CityId target) {
+    ShortestPathResult res;
+    res.found = false;
+    res.distance = 0;
+    res.settledNodes = 0;
+
+    if (tree.dist[target] == INT_MAX) {
+        res.message = "No route exists between these cities.";
+        return res;
     }
 
+    res.found = true;
+    res.distance = tree.dist[target];
+    appendPath(g, [&](CityId c) { return tree.parent[c]; }, tree.source, target, res.path);
+    res.message = "Shortest path found successfully.";
     return res;
 }
@@ -0,0 +1,304 @@
+#include "../include/TourSearch.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+int TourSearch::cost(const vector<int>& dist, int n, const vector<int>& tour) {
+    int total = 0;
+    for (size_t i = 0; i + 1 < tour.size(); ++i) total += dist[tour[i] * n + tour[i + 1]];
+    return total;
+}
+
+vector<int> TourSearch::heuristic(const vector<int>& dist, int n, Deadline deadline) {
+    vector<int> tour = {0};
+    vector<bool> used(n, false);
+    used[0] = true;
+    for (int step = 1; step < n; ++step) {
+        int cur = tour.back(), next = -1;
+        for (int j = 0; j < n; ++j) {
+            if (!used[j] && (next == -1 || dist[cur * n + j] < dist[cur * n + next])) next = j;
+        }
+        used[next] = true;
+        tour.push_back(next);
+    }
+
+    // Alternate the two neighbourhoods until neither finds an improving move
+    bool improved = true;
+    while (improved && chrono::steady_clock::now() < deadline) {
+        improved = twoOpt(dist, n, tour, deadline);
+        improved = orOpt(dist, n, tour, deadline) || improved;
+    }
+    return tour;
+}
+
+// Both neighbourhoods check the deadline once per O(n) scan and stop with
+// the tour as improved so far
+bool TourSearch::twoOpt(const vector<int>& dist, int n, vector<int>& tour, Deadline deadline) {
+    bool any = false, improved = true;
+    while (improved) {
+        improved = false;
+        for (int i = 1; i + 1 < n; ++i) {
+            if (chrono::steady_clock::now() >= deadline) return any;
+            for (int j = i + 1; j < n; ++j) {
+                // Reversing tour[i..j] trades (a,b),(c,d) for (a,c),(b,d); the last stop has no d
+                int a = tour[i - 1], b = tour[i], c = tour[j];
+                int delta = dist[a * n + c] - dist[a * n + b];
+                if (j + 1 < n) {
+                    int d = tour[j + 1];
+                    delta += dist[b * n + d] - dist[c * n + d];
+                }
+                if (delta < 0) {
+                    reverse(tour.begin() + i, tour.begin() + j + 1);
+                    improved = any = true;
+                }
+            }
+        }
+    }
+    return any;
+}
+
+bool TourSearch::orOpt(const vector<int>& dist, int n, vector<int>& tour, Deadline deadline) {
+    bool any = false, improved = true;
+    while (improved) {
+        improved = false;
+        for (int len = 1; len <= 3; ++len) {
+            for (int i = 1; i + len <= n; ++i) {
+                if (chrono::steady_clock::now() >= deadline) return any;
+                // Saving from cutting tour[i .. i+len) out and closing the gap
+                int first = tour[i], last = tour[i + len - 1], prev = tour[i - 1];
+                int saved = dist[prev * n + first];
+                if (i + len < n) {
+                    int next = tour[i + len];
+                    saved += dist[last * n + next] - dist[prev * n + next];
+                }
+
+                // Re-insert after tour[j], in either orientation
+                int bestDelta = 0, bestJ = -1;
+                bool bestReversed = false;
+                for (int j = 0; j < n; ++j) {
+                    if (j >= i - 1 && j < i + len) continue;
+                    int a = tour[j];
+                    for (int r = 0; r < 2; ++r) {
+                        int head = r ? last : first, tail = r ? first : last;
+                        int added = dist[a * n + head];
+                        if (j + 1 < n) {
+                            int b = tour[j + 1];
+                            added += dist[tail * n + b] - dist[a * n + b];
+                        }
+                        if (added - saved < bestDelta) {
+                            bestDelta = added - saved;
+                            bestJ = j;
+                            bestReversed = r;
+                        }
+                    }
+                }
+                if (bestJ == -1) continue;
+
+                vector<int> segment(tour.begin() + i, tour.begin() + i + len);
+                if (bestReversed) reverse(segment.begin(), segment.end());
+                int anchor = tour[bestJ];
+                tour.erase(tour.begin() + i, tour.begin() + i + len);
+                auto at = find(tour.begin(), tour.end(), anchor) + 1;
+                tour.insert(at, segment.begin(), segment.end());
+                improved = any = true;
+            }
+        }
+    }
+    return any;
+}
+
+// --- Parallel branch and bound ---
+namespace {
+
+struct BnBTask {
+    vector<int> path;
+    int cost;
+};
+
+// The owner pushes and pops at the back; thieves take from the front, where
+// the shallowest (largest) subtrees sit.
+struct WorkerDeque {
+    mutex lock;
+    deque<BnBTask> tasks;
+};
+
+// Per-worker buffers so the search does not allocate per node
+struct Scratch {
+    vector<char> visited;
+    vector<vector<int>> children;   // per depth, unvisited stops nearest-first
+    vector<int> rest;
+    vector<int> key;
+    long nodes = 0;
+};
+
+class BranchAndBound {
+public:
+    BranchAndBound(const vector<int>& dist, int n, const vector<int>& tour,
+                   TourSearch::Deadline deadline, int threads)
+        : dist(dist), n(n), deadline(deadline), deques(threads), bestTour(tour) {
+        bestCost = TourSearch::cost(dist, n, tour);
+
+        // Split the top levels into tasks until there are a few dozen per worker
+        long count = 1;
+        splitDepth = 1;
+        while (count < 32L * threads && splitDepth < n) {
+            count *= n - splitDepth;
+            splitDepth++;
+        }
+    }
+
+    bool run(vector<int>& tour) {
+        int threads = deques.size();
+        deques[0].tasks.push_back({{0}, 0});
+        pending = 1;
+
+        vector<thread> helpers;
+        for (int id = 1; id < threads; ++id) helpers.emplace_back(&BranchAndBound::worker, this, id);
+        worker(0);
+        for (auto& t : helpers) t.join();
+
+        tour = bestTour;
+        return !timedOut;
+    }
+
+private:
+    const vector<int>& dist;
+    int n;
+    int splitDepth;
+    TourSearch::Deadline deadline;
+    vector<WorkerDeque> deques;
+
+    atomic<long> pending{0};
+    atomic<bool> timedOut{false};
+    atomic<int> bestCost{INT_MAX};
+    mutex bestLock;
+    vector<int> bestTour;
+
+    bool take(int id, BnBTask& task) {
+        {
+            WorkerDeque& own = deques[id];
+            lock_guard<mutex> guard(own.lock);
+            if (!own.tasks.empty()) {
+                task = move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < deques.size(); ++k) {
+            WorkerDeque& victim = deques[(id + k) % deques.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker(int id) {
+        Scratch s;
+        s.visited.assign(n, 0);
+        s.children.resize(n + 1);
+        s.key.resize(n);
+
+        while (!timedOut) {
+            BnBTask task;
+            if (!take(id, task)) {
+                if (pending == 0) return;
+                this_thread::yield();
+                continue;
+            }
+            for (int c : task.path) s.visited[c] = 1;
+            search(id, s, task.path, task.cost);
+            for (int c : task.path) s.visited[c] = 0;
+            pending--;
+        }
+    }
+
+    // Cheapest edge from `end` into the unvisited stops plus their MST; the rest
+    // of any tour is such an edge followed by a path spanning them
+    int lowerBound(int end, Scratch& s) {
+        s.rest.clear();
+        for (int c = 0; c < n; ++c) if (!s.visited[c]) s.rest.push_back(c);
+        if (s.rest.empty()) return 0;
+
+        int bound = INT_MAX;
+        for (int c : s.rest) bound = min(bound, dist[end * n + c]);
+
+        // Prim over rest; key[i] is the cheapest edge from rest[i] into the tree
+        int k = s.rest.size();
+        for (int i = 1; i < k; ++i) s.key[i] = dist[s.rest[0] * n + s.rest[i]];
+        for (int added = 1; added < k; ++added) {
+            int pick = added;
+            for (int i = added + 1; i < k; ++i) if (s.key[i] < s.key[pick]) pick = i;
+            swap(s.rest[added], s.rest[pick]);
+            swap(s.key[added], s.key[pick]);
+            bound += s.key[added];
+            int u = s.rest[added];
+            for (int i = added + 1; i < k; ++i) s.key[i] = min(s.key[i], dist[u * n + s.rest[i]]);
+        }
+        return bound;
+    }
+
+    void search(int id, Scratch& s, vector<int>& path, int cost) {
+        if (timedOut) return;
+        if (++s.nodes % 1024 == 0 && chrono::steady_clock::now() >= deadline) {
+            timedOut = true;
+            return;
+        }
+
+        int end = path.back();
+        if ((int)path.size() == n) {
+            if (cost < bestCost) {
+                lock_guard<mutex> guard(bestLock);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestTour = path;
+                }
+            }
+            return;
+        }
+        if (cost + lowerBound(end, s) >= bestCost) return;
+
+        vector<int>& children = s.children[path.size()];
+        children.clear();
+        for (int c = 0; c < n; ++c) if (!s.visited[c]) children.push_back(c);
+        sort(children.begin(), children.end(),
+             [&](int a, int b) { return dist[end * n + a] < dist[end * n + b]; });
+
+        if ((int)path.size() < splitDepth) {
+            // Hand the subtrees out; pushed farthest-first so the owner pops the nearest
+            WorkerDeque& own = deques[id];
+            lock_guard<mutex> guard(own.lock);
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                BnBTask child{path, cost + dist[end * n + *it]};
+                child.path.push_back(*it);
+                own.tasks.push_back(move(child));
+                pending++;
+            }
+            return;
+        }
+
+        for (int c : children) {
+            int next = cost + dist[end * n + c];
+            if (next >= bestCost) break;
+            s.visited[c] = 1;
+            path.push_back(c);
+            search(id, s, path, next);
+            path.pop_back();
+            s.visited[c] = 0;
+        }
+    }
+};
+
+}
+
+bool TourSearch::branchAndBound(const vector<int>& dist, int n, vector<int>& tour,
+                                Deadline deadline, int threads) {
+    BranchAndBound bnb(dist, n, tour, deadline, max(threads, 1));
+    return bnb.run(tour);
+}
@@ -0,0 +1,78 @@
+#include "../include/WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+
+static atomic<int> concurrencyLimit{0};   // 0: every core
+static thread_local bool inPoolJob = false;
+
+int WorkerPool::concurrency() {
+    int limit = concurrencyLimit.load(memory_order_relaxed);
+    return limit > 0 ? limit : max(thread::hardware_concurrency(), 1u);
+}
+
+void WorkerPool::setConcurrency(int threads) {
+    concurrencyLimit.store(max(threads, 0), memory_order_relaxed);
+}
+
+int WorkerPool::threadsHere() {
+    return inPoolJob ? 1 : concurrency();
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkerPool::run(const function<void()>& work) {
+    // Either way the job shares the cores with other jobs, so code inside it
+    // sees threadsHere() == 1
+    bool outer = inPoolJob;
+    inPoolJob = true;
+    unique_lock<mutex> busy(runLock, try_to_lock);
+    if (!busy.owns_lock()) {
+        work();
+        inPoolJob = outer;
+        return;
+    }
+
+    // The caller is one of the workers, so start one thread fewer than cores
+    if (threads.empty()) {
+        int cores = concurrency();
+        for (int i = 1; i < cores; ++i) threads.emplace_back(&WorkerPool::loop, this, generation);
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        job = &work;
+        generation++;
+        running = threads.size();
+    }
+    wake.notify_all();
+    work();
+    inPoolJob = outer;
+
+    unique_lock<mutex> guard(lock);
+    done.wait(guard, [&] { return running == 0; });
+    job = nullptr;
+}
+
+// `seen` is the generation the thread was started in; it waits for the next one
+void WorkerPool::loop(uint64_t seen) {
+    inPoolJob = true;
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        const function<void()>& work = *job;
+
+        guard.unlock();
+        work();
+        guard.lock();
+        if (--running == 0) done.notify_one();
+    }
+}
@@ -1,9 +1,31 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include "cpp_src/include/PathFinder.h"
+#include <climits>
+#include <type_traits>
 
 namespace py = pybind11;
 
+// Lets other Python threads run while a call is inside C++
+using ReleaseGIL = py::call_guard<py::gil_scoped_release>;
+
+// Copies a 1-D integer array into ints through its widest type of the same
+// signedness, so no value is rounded or wrapped; returns an error otherwise
+template <typename Wide>
+static string narrowInts(const py::array& values, vector<int>& out) {
+    auto wide = py::array_t<Wide, py::array::c_style | py::array::forcecast>::ensure(values);
+    const Wide* p = wide.data();
+    out.resize(wide.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (p[i] > (Wide)INT_MAX || (is_signed<Wide>::value && p[i] < (Wide)INT_MIN)) {
+            return "Distance does not fit in a 32-bit int (row " + to_string(i) + ").";
+        }
+        out[i] = (int)p[i];
+    }
+    return "";
+}
+
 PYBIND11_MODULE(pathfinder, m) {
     m.doc() = "Modular Path Finder Engine";
 
@@ -13,13 +35,29 @@ PYBIND11_MODULE(pathfinder, m) {
         .def_readwrite("success", &OperationResult::success)
         .def_readwrite("message", &OperationResult::message);
 
+    // SearchMode for find_shortest_path
+    py::enum_<SearchMode>(m, "SearchMode")
+        .value("DIJKSTRA", SearchMode::Dijkstra)
+        .value("BIDIRECTIONAL", SearchMode::Bidirectional)
+        .value("ASTAR", SearchMode::AStar)
+        .value("CONTRACTION_HIERARCHY", SearchMode::ContractionHierarchy)
+        .value("ALT", SearchMode::ALT);
+
+    // MSTAlgorithm for find_cheapest_network
+    py::enum_<MSTAlgorithm>(m, "MSTAlgorithm")
+        .value("AUTO", MSTAlgorithm::Auto)
+        .value("KRUSKAL", MSTAlgorithm::Kruskal)
+        .value("FILTER_KRUSKAL", MSTAlgorithm::FilterKruskal)
+        .value("BORUVKA", MSTAlgorithm::Boruvka);
+
     // ShortestPathResult structure
     py::class_<ShortestPathResult>(m, "ShortestPathResult")
         .def(py::init<>())
         .def_readwrite("found", &ShortestPathResult::found)
         .def_readwrite("path", &ShortestPathResult::path)
         .def_readwrite("distance", &ShortestPathResult::distance)
-        .def_readwrite("message", &ShortestPathResult::message);
+        .def_readwrite("message", &ShortestPathResult::message)
+        .def_readwrite("settledNodes", &ShortestPathResult::settledNodes);
 
     // LongestPathResult structure
     py::class_<LongestPathResult>(m, "LongestPathResult")
@@ -27,7 +65,8 @@ PYBIND11_MODULE(pathfinder, m) {
         .def_readwrite("found", &LongestPathResult::found)
         .def_readwrite("path", &LongestPathResult::path)
         .def_readwrite("distance", &LongestPathResult::distance)
-        .def_readwrite("message", &LongestPathResult::message);
+        .def_readwrite("message", &LongestPathResult::message)
+        .def_readwrite("provenLongest", &LongestPathResult::provenLongest);
 
     // FewestStopsResult
     py::class_<FewestStopsResult>(m, "FewestStopsResult")
@@ -43,7 +82,8 @@ PYBIND11_MODULE(pathfinder, m) {
         .def_readwrite("found", &TourResult::found)
         .def_readwrite("path", &TourResult::path)
         .def_readwrite("totalDistance", &TourResult::totalDistance)
-        .def_readwrite("message", &TourResult::message);
+        .def_readwrite("message", &TourResult::message)
+        .def_readwrite("provenOptimal", &TourResult::provenOptimal);
 
     // MSTResult
     py::class_<MSTResult>(m, "MSTResult")
@@ -53,39 +93,164 @@ PYBIND11_MODULE(pathfinder, m) {
         .def_readwrite("totalCost", &MSTResult::totalCost)
         .def_readwrite("message", &MSTResult::message);
 
+    // QueryKind for batch_query
+    py::enum_<QueryKind>(m, "QueryKind")
+        .value("SHORTEST_PATH", QueryKind::ShortestPath)
+        .value("FEWEST_STOPS", QueryKind::FewestStops)
+        .value("LONGEST_PATH", QueryKind::LongestPath);
+
+    // BatchResult structure
+    py::class_<BatchResult>(m, "BatchResult")
+        .def(py::init<>())
+        .def_readwrite("found", &BatchResult::found)
+        .def_readwrite("path", &BatchResult::path)
+        .def_readwrite("distance", &BatchResult::distance)
+        .def_readwrite("message", &BatchResult::message);
+
+    // CacheStats for get_cache_stats
+    py::class_<CacheStats>(m, "CacheStats")
+        .def(py::init<>())
+        .def_readwrite("hits", &CacheStats::hits)
+        .def_readwrite("treeHits", &CacheStats::treeHits)
+        .def_readwrite("misses", &CacheStats::misses)
+        .def_readwrite("entries", &CacheStats::entries)
+        .def_readwrite("trees", &CacheStats::trees);
+
     // PathFinder class
     py::class_<PathFinder>(m, "PathFinder")
         .def(py::init<>())
         .def("add_city", &PathFinder::addCity,
-             "Add a route between two cities",
-             py::arg("city1"), py::arg("city2"), py::arg("distance"))
+             "Add a route between two cities, optionally with (lat, lon) for each city",
+             ReleaseGIL(),
+             py::arg("city1"), py::arg("city2"), py::arg("distance"),
+             py::arg("location1") = py::none(), py::arg("location2") = py::none())
+        .def("set_city_location", &PathFinder::setCityLocation,
+             "Set the latitude/longitude of a city (used by A* search)",
+             ReleaseGIL(),
+             py::arg("city"), py::arg("latitude"), py::arg("longitude"))
         .def("update_city", &PathFinder::updateCity,
              "Update an existing route between two cities",
+             ReleaseGIL(),
              py::arg("city1"), py::arg("city2"), py::arg("distance"))
         .def("remove_city", &PathFinder::removeCity,
              "Remove a route between two cities",
+             ReleaseGIL(),
              py::arg("city1"), py::arg("city2"))
+        .def("load_edges",
+             [](PathFinder& pf, vector<string> sources, vector<string> destinations,
+                py::array distances) {
+                 // Any int sequence or integer numpy array; copied once while the GIL is held
+                 vector<int> weights;
+                 string error;
+                 char kind = distances.dtype().kind();
+                 // An empty list arrives as float64, and holds no values to lose
+                 if (distances.ndim() != 1 || (distances.size() > 0 && kind != 'i' && kind != 'u')) {
+                     error = "Distances must be a 1-D sequence of integers.";
+                 } else if (kind == 'u') {
+                     error = narrowInts<uint64_t>(distances, weights);
+                 } else {
+                     error = narrowInts<int64_t>(distances, weights);
+                 }
+                 if (!error.empty()) return OperationResult{false, error};
+                 py::gil_scoped_release release;
+                 return pf.loadEdges(sources, destinations, weights);
+             },
+             "Add many routes at once from parallel sequences or numpy arrays of names and distances",
+             py::arg("sources"), py::arg("destinations"), py::arg("distances"))
         .def("find_shortest_path", &PathFinder::findShortestPath,
              "Find the shortest path between two cities using Dijkstra's algorithm",
-             py::arg("start"), py::arg("end"))
+             ReleaseGIL(),
+             py::arg("start"), py::arg("end"), py::arg("mode") = SearchMode::Dijkstra)
+        .def("prepare_contraction_hierarchy", &PathFinder::prepareContractionHierarchy,
+             "Preprocess the current network for CONTRACTION_HIERARCHY queries",
+             ReleaseGIL())
+        .def("set_landmark_count", &PathFinder::setLandmarkCount,
+             "Set how many ALT landmarks to precompute (memory is k x cities)",
+             ReleaseGIL(),
+             py::arg("k"))
+        .def("prepare_landmarks", &PathFinder::prepareLandmarks,
+             "Precompute ALT landmark tables for the current network",
+             ReleaseGIL())
+        .def("distance_matrix",
+             [](PathFinder& pf, vector<string> sources, vector<string> targets) {
+                 // The int32 buffer is handed to numpy as-is; the capsule owns it
+                 DistanceMatrix* m;
+                 {
+                     py::gil_scoped_release release;
+                     m = new DistanceMatrix(pf.distanceMatrix(move(sources), move(targets)));
+                 }
+                 py::capsule owner(m, [](void* p) { delete static_cast<DistanceMatrix*>(p); });
+                 return py::array_t<int>({(py::ssize_t)m->rows, (py::ssize_t)m->cols},
+                                         m->distances.data(), owner);
+             },
+             "Shortest distances from every source to every target as a 2-D numpy array (-1 = unreachable)",
+             py::arg("sources"), py::arg("targets"))
         .def("find_longest_path", &PathFinder::findLongestPath,
-             "Find the longest simple path between two cities using DFS",
-             py::arg("start"), py::arg("end"))
+             "Find the longest simple path between two cities; returns the best found within the budget",
+             ReleaseGIL(),
+             py::arg("start"), py::arg("end"),
+             py::arg("time_budget_ms") = LongestPath::DEFAULT_TIME_BUDGET_MS,
+             py::arg("node_budget") = 0)
         .def("find_fewest_stops", &PathFinder::findFewestStops,
              "Find path with fewest stops using BFS",
+             ReleaseGIL(),
              py::arg("start"), py::arg("end"))
+        .def("hop_counts", &PathFinder::hopCounts,
+             "Fewest stops from the nearest source to every reachable city, as (city, hops) pairs",
+             ReleaseGIL(),
+             py::arg("sources"))
+        .def("batch_query", &PathFinder::batchQuery,
+             "Answer a list of (QueryKind, start, end) requests in parallel; results keep the request order",
+             ReleaseGIL(),
+             py::arg("requests"), py::arg("mode") = SearchMode::Dijkstra)
         .def("find_reachable_cities", &PathFinder::findReachableCities,
              "Find all reachable cities from start",
+             ReleaseGIL(),
              py::arg("start"))
         .def("plan_multi_city_tour", &PathFinder::planMultiCityTour,
-             "Plan a multi-city tour",
-             py::arg("cities"))
+             "Plan a multi-city tour; tours above 20 stops return the best found within the time budget",
+             ReleaseGIL(),
+             py::arg("cities"), py::arg("time_budget_ms") = MultiCityTour::DEFAULT_TIME_BUDGET_MS)
         .def("find_cheapest_network", &PathFinder::findCheapestNetwork,
-             "Find the cheapest network (MST)")
+             "Find the cheapest network (MST)",
+             ReleaseGIL(),
+             py::arg("algorithm") = MSTAlgorithm::Auto)
         .def("get_all_cities", &PathFinder::getAllCities,
-             "Get all cities in the graph")
+             "Get all cities in the graph",
+             ReleaseGIL())
         .def("get_all_routes", &PathFinder::getAllRoutes,
-             "Get all routes in the graph")
+             "Get all routes in the graph",
+             ReleaseGIL())
         .def("clear_all", &PathFinder::clearAll,
-             "Clear all data");
+             "Clear all data",
+             ReleaseGIL())
+        .def("save_snapshot", &PathFinder::saveSnapshot,
+             "Write the network and its preprocessing to a binary snapshot file",
+             ReleaseGIL(),
+             py::arg("path"))
+        .def("open_snapshot", &PathFinder::openSnapshot,
+             "Replace the network with one memory-mapped from a snapshot file",
+             ReleaseGIL(),
+             py::arg("path"), py::arg("verify_checksum") = true)
+        .def("set_hot_sources", &PathFinder::setHotSources,
+             "Keep shortest-path trees for these cities repaired across route edits",
+             ReleaseGIL(),
+             py::arg("cities"))
+        .def("get_hot_sources", &PathFinder::getHotSources,
+             "Cities whose shortest-path trees are being maintained",
+             ReleaseGIL())
+        .def("set_cache_capacity", &PathFinder::setCacheCapacity,
+             "Set how many shortest-path and fewest-stops results to cache (0 disables)",
+             ReleaseGIL(),
+             py::arg("entries"))
+        .def("set_tree_cache_capacity", &PathFinder::setTreeCacheCapacity,
+             "Set how many full shortest-path trees to cache (0 disables; each holds two ints per city)",
+             ReleaseGIL(),
+             py::arg("trees"))
+        .def("get_cache_stats", &PathFinder::getCacheStats,
+             "Query cache hit/miss counters and current sizes",
+             ReleaseGIL())
+        .def("clear_cache", &PathFinder::clearCache,
+             "Drop all cached results and reset the counters",
+             ReleaseGIL());
 }
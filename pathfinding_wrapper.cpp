@@ -4,6 +4,9 @@
 
 namespace py = pybind11;
 
+// Lets other Python threads run while a call is inside C++
+using ReleaseGIL = py::call_guard<py::gil_scoped_release>;
+
 PYBIND11_MODULE(pathfinding, m) {
     m.doc() = "Travel Planner C++ Pathfinding Engine";
 
@@ -32,25 +35,41 @@ PYBIND11_MODULE(pathfinding, m) {
         .def(py::init<>())
         .def("add_route", &TravelPlannerLib::addRoute,
              "Add a route between two cities",
+             ReleaseGIL(),
              py::arg("source"), py::arg("destination"), py::arg("distance"))
         .def("delete_route", &TravelPlannerLib::deleteRoute,
              "Delete a route between two cities",
+             ReleaseGIL(),
              py::arg("source"), py::arg("destination"))
         .def("find_shortest_path", &TravelPlannerLib::findShortestPath,
              "Find the shortest path between two cities using Dijkstra's algorithm",
+             ReleaseGIL(),
              py::arg("start"), py::arg("end"))
         .def("find_fewest_stops", &TravelPlannerLib::findFewestStops,
              "Find the path with fewest stops between two cities using BFS",
+             ReleaseGIL(),
              py::arg("start"), py::arg("end"))
         .def("get_reachable_cities", &TravelPlannerLib::getReachableCities,
              "Get all cities reachable from a starting city",
+             ReleaseGIL(),
              py::arg("start"))
         .def("get_map_stats", &TravelPlannerLib::getMapStats,
-             "Get statistics about the map")
+             "Get statistics about the map",
+             ReleaseGIL())
         .def("get_all_cities", &TravelPlannerLib::getAllCities,
-             "Get all cities in the map")
+             "Get all cities in the map",
+             ReleaseGIL())
         .def("get_all_routes", &TravelPlannerLib::getAllRoutes,
-             "Get all routes in the map")
+             "Get all routes in the map",
+             ReleaseGIL())
         .def("clear", &TravelPlannerLib::clear,
-             "Clear all data from the map");
+             "Clear all data from the map",
+             ReleaseGIL())
+        .def("get_version", &TravelPlannerLib::getVersion,
+             "Version recorded by the last apply_changes call (0 after clear)",
+             ReleaseGIL())
+        .def("apply_changes", &TravelPlannerLib::applyChanges,
+             "Apply (source, destination, distance) upserts and (source, destination) deletions in one call",
+             ReleaseGIL(),
+             py::arg("upserts"), py::arg("deletions"), py::arg("version"));
 }
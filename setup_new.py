@@ -12,7 +12,14 @@ cpp_sources = [
     'cpp_src/src/FewestStops.cpp',
     'cpp_src/src/ReachableCities.cpp',
     'cpp_src/src/MultiCityTour.cpp',
+    'cpp_src/src/TourSearch.cpp',
     'cpp_src/src/CheapestNetwork.cpp',
+    'cpp_src/src/DynamicMST.cpp',
+    'cpp_src/src/DynamicSPT.cpp',
+    'cpp_src/src/ContractionHierarchy.cpp',
+    'cpp_src/src/Landmarks.cpp',
+    'cpp_src/src/GraphSnapshot.cpp',
+    'cpp_src/src/WorkerPool.cpp',
     'cpp_src/src/PathFinder.cpp',
 ]
 
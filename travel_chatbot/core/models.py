@@ -1,4 +1,6 @@
 from django.db import models
+from django.db.models.signals import pre_save, post_save, post_delete
+from django.dispatch import receiver
 import uuid
 
 
@@ -36,6 +38,44 @@ class Route(models.Model):
         super().save(*args, **kwargs)
 
 
+class RouteChange(models.Model):
+    """Append-only log of route edits; ids are the graph versions the engine syncs to"""
+    source = models.CharField(max_length=100)
+    destination = models.CharField(max_length=100)
+    distance = models.IntegerField(blank=True, null=True, help_text="Null when the route was deleted")
+    created_at = models.DateTimeField(auto_now_add=True)
+
+    class Meta:
+        ordering = ['id']
+
+    def __str__(self):
+        action = "deleted" if self.distance is None else f"{self.distance}km"
+        return f"#{self.id} {self.source} <-> {self.destination} ({action})"
+
+
+# Every save or delete of a Route is logged. Bulk queryset updates and deletes
+# skip these signals and are only picked up by a full reload.
+@receiver(pre_save, sender=Route)
+def log_route_moved(sender, instance, **kwargs):
+    if not instance.pk:
+        return
+    old = Route.objects.select_related('source', 'destination').filter(pk=instance.pk).first()
+    if old and (old.source_id, old.destination_id) != (instance.source_id, instance.destination_id):
+        RouteChange.objects.create(source=old.source.name, destination=old.destination.name)
+
+
+@receiver(post_save, sender=Route)
+def log_route_saved(sender, instance, **kwargs):
+    RouteChange.objects.create(source=instance.source.name,
+                               destination=instance.destination.name,
+                               distance=instance.distance)
+
+
+@receiver(post_delete, sender=Route)
+def log_route_deleted(sender, instance, **kwargs):
+    RouteChange.objects.create(source=instance.source.name, destination=instance.destination.name)
+
+
 class ChatSession(models.Model):
     """Represents a chat conversation session"""
     session_id = models.UUIDField(default=uuid.uuid4, unique=True, editable=False)
@@ -1,5 +1,6 @@
 import sys
 import os
+from datetime import timedelta
 from typing import Dict, Any, List, Tuple
 from django.conf import settings
 
@@ -12,6 +13,10 @@ except ImportError:
     print("Warning: C++ pathfinding module not available. Using fallback.")
     CPP_AVAILABLE = False
 
+# A RouteChange id can commit after a higher one. A missing id newer than this
+# may still be in flight; an older one is taken to be a rolled-back insert.
+CHANGE_GAP_TIMEOUT = timedelta(seconds=60)
+
 
 class PathfindingService:
     """
@@ -24,26 +29,77 @@ class PathfindingService:
             self.engine = pathfinding.TravelPlannerLib()
         else:
             self.engine = None
+        self.loaded = False
+    
+    def _committed_head(self, after):
+        """
+        Highest RouteChange id h >= after such that every id in (after, h] is
+        visible. Syncing stops at a gap, so a change that commits late is not
+        skipped; gaps older than CHANGE_GAP_TIMEOUT are treated as closed.
+        """
+        from django.db.models import Max
+        from django.utils import timezone
+        from core.models import RouteChange
+        
+        cutoff = timezone.now() - CHANGE_GAP_TIMEOUT
+        settled = RouteChange.objects.filter(created_at__lt=cutoff).aggregate(head=Max('id'))['head'] or 0
+        head = max(after, settled)
+        for change_id in RouteChange.objects.filter(id__gt=head).order_by('id').values_list('id', flat=True):
+            if change_id != head + 1:
+                break
+            head = change_id
+        return head
     
     def sync_with_database(self):
-        """Load routes from Django database into C++ engine"""
+        """
+        Bring the C++ engine up to date with the database.
+        The engine's version is the id of the last RouteChange it applied, so
+        only changes logged after it are sent, coalesced into one bulk call.
+        The version only advances over contiguous ids (see _committed_head).
+        A sync with nothing new is a single aggregate query.
+        """
         if not CPP_AVAILABLE or not self.engine:
             return False
         
-        from core.models import Route
+        from django.db.models import Max
+        from core.models import Route, RouteChange
+        
+        latest = RouteChange.objects.aggregate(latest=Max('id'))['latest'] or 0
+        version = self.engine.get_version()
+        
+        if not self.loaded or latest < version:
+            # First sync, or the log was reset: reload everything. The head is
+            # read first, so changes racing with the load are re-sent next time
+            head = self._committed_head(0)
+            self.engine.clear()
+            routes = Route.objects.select_related('source', 'destination').all()
+            # Rows the engine would reject are skipped, as add_route used to
+            upserts = [(r.source.name, r.destination.name, r.distance) for r in routes
+                       if r.distance > 0 and r.source_id != r.destination_id]
+            result = self.engine.apply_changes(upserts, [], head)
+            self.loaded = result.success
+            return result.success
+        
+        if latest == version:
+            return True
         
-        # Clear existing data
-        self.engine.clear()
+        head = self._committed_head(version)
+        if head == version:
+            return True
         
-        # Load all routes from database
-        routes = Route.objects.select_related('source', 'destination').all()
-        for route in routes:
-            self.engine.add_route(
-                route.source.name,
-                route.destination.name,
-                route.distance
-            )
+        # Last write wins per route
+        final = {}
+        changes = RouteChange.objects.filter(id__gt=version, id__lte=head).order_by('id')
+        for change in changes:
+            final[(change.source, change.destination)] = change.distance
         
+        upserts = [(s, d, dist) for (s, d), dist in final.items() if dist is not None]
+        deletions = [(s, d) for (s, d), dist in final.items() if dist is None]
+        result = self.engine.apply_changes(upserts, deletions, head)
+        if not result.success:
+            # Fall back to a full reload rather than serve a half-synced map
+            self.loaded = False
+            return self.sync_with_database()
         return True
     
     def add_route(self, source: str, destination: str, distance: int) -> Dict[str, Any]:
@@ -1,3 +1,88 @@
-from django.test import TestCase
+import os
+import sys
+import threading
+import unittest
 
-# Create your tests here.
+from django.test import SimpleTestCase
+
+# The extension is built in the repository root (python setup_new.py build_ext --inplace)
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+try:
+    import pathfinder
+except ImportError:
+    pathfinder = None
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+@unittest.skipUnless(pathfinder, "pathfinder extension not built")
+class PathFinderBindingTests(SimpleTestCase):
+    """Calls each binding added on top of the original module at least once"""
+
+    def setUp(self):
+        self.pf = pathfinder.PathFinder()
+        result = self.pf.load_edges(['A', 'B', 'C', 'A'], ['B', 'C', 'D', 'D'], [1, 2, 3, 10])
+        self.assertTrue(result.success, result.message)
+
+    def test_load_edges_accepts_integer_sequences(self):
+        self.assertTrue(self.pf.load_edges([], [], []).success)
+        self.assertEqual(self.pf.find_shortest_path('A', 'D').distance, 6)
+        if np is not None:
+            result = self.pf.load_edges(['D'], ['E'], np.array([4], dtype=np.uint16))
+            self.assertTrue(result.success, result.message)
+            self.assertEqual(self.pf.find_shortest_path('A', 'E').distance, 10)
+
+    def test_load_edges_rejects_lossy_distances(self):
+        self.assertFalse(self.pf.load_edges(['A', 'B'], ['X', 'Y'], [1.9, 2]).success)
+        self.assertFalse(self.pf.load_edges(['A', 'B'], ['X', 'Y'], [1, 2 ** 40]).success)
+        self.assertFalse(self.pf.load_edges(['A'], ['a'], [5]).success)
+        self.assertFalse(self.pf.add_city('A', 'a', 5).success)
+        self.assertNotIn('X', self.pf.get_all_cities())
+
+    def test_batch_query_keeps_request_order(self):
+        kinds = pathfinder.QueryKind
+        requests = [(kinds.SHORTEST_PATH, 'A', 'D'),
+                    (kinds.FEWEST_STOPS, 'A', 'D'),
+                    (kinds.LONGEST_PATH, 'A', 'D'),
+                    (kinds.SHORTEST_PATH, 'A', 'Nowhere')] * 50
+        results = self.pf.batch_query(requests)
+        self.assertEqual(len(results), len(requests))
+        self.assertEqual([r.distance for r in results[:3]], [6, 1, 10])
+        self.assertFalse(results[3].found)
+
+    def test_distance_matrix_is_a_numpy_table(self):
+        if np is None:
+            self.skipTest("numpy not installed")
+        table = self.pf.distance_matrix(['A', 'B'], ['C', 'D', 'Nowhere'])
+        self.assertEqual(table.shape, (2, 3))
+        self.assertEqual(table.tolist(), [[3, 6, -1], [2, 5, -1]])
+
+    def test_queries_release_the_gil(self):
+        # Queries from several Python threads against one shared engine
+        errors = []
+
+        def query():
+            for _ in range(200):
+                if self.pf.find_shortest_path('A', 'D').distance != 6:
+                    errors.append('wrong distance')
+
+        threads = [threading.Thread(target=query) for _ in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(errors, [])
+
+    def test_snapshot_round_trip(self):
+        path = os.path.join(os.path.dirname(__file__), 'test_bindings.snap')
+        try:
+            self.assertTrue(self.pf.save_snapshot(path).success)
+            other = pathfinder.PathFinder()
+            self.assertTrue(other.open_snapshot(path, verify_checksum=False).success)
+            self.assertEqual(other.find_shortest_path('A', 'D').distance, 6)
+        finally:
+            if os.path.exists(path):
+                os.remove(path)
@@ -9,9 +9,35 @@ import os
 sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
 import pathfinder
 
-# Global pathfinder instance
+# Global pathfinder instance; safe to share across request threads, since
+# queries read a published snapshot while edits build the next one
 pf = pathfinder.PathFinder()
 
+# Workers start from a prebuilt snapshot (see PathFinder.save_snapshot) when
+# one is configured; it is memory-mapped, so every process shares its pages
+SNAPSHOT_PATH = os.environ.get('PATHFINDER_SNAPSHOT')
+if SNAPSHOT_PATH and os.path.exists(SNAPSHOT_PATH):
+    result = pf.open_snapshot(SNAPSHOT_PATH)
+    if not result.success:
+        print(f"Warning: {result.message}")
+
+# Shortest-path search modes accepted in the request body
+SEARCH_MODES = {
+    'dijkstra': pathfinder.SearchMode.DIJKSTRA,
+    'bidirectional': pathfinder.SearchMode.BIDIRECTIONAL,
+    'astar': pathfinder.SearchMode.ASTAR,
+    'ch': pathfinder.SearchMode.CONTRACTION_HIERARCHY,
+    'alt': pathfinder.SearchMode.ALT,
+}
+
+# MST algorithms accepted as ?algorithm= on cheapest_network
+MST_ALGORITHMS = {
+    'auto': pathfinder.MSTAlgorithm.AUTO,
+    'kruskal': pathfinder.MSTAlgorithm.KRUSKAL,
+    'filter_kruskal': pathfinder.MSTAlgorithm.FILTER_KRUSKAL,
+    'boruvka': pathfinder.MSTAlgorithm.BORUVKA,
+}
+
 def index(request):
     """Render the main pathfinder UI"""
     return render(request, 'pathfinder.html')
@@ -24,8 +50,12 @@ def add_route(request):
         city1 = data.get('city1')
         city2 = data.get('city2')
         distance = int(data.get('distance'))
+        location1 = data.get('location1')  # optional [lat, lon]
+        location2 = data.get('location2')
         
-        result = pf.add_city(city1, city2, distance)
+        result = pf.add_city(city1, city2, distance,
+                             tuple(location1) if location1 else None,
+                             tuple(location2) if location2 else None)
         return JsonResponse({
             'success': result.success,
             'message': result.message
@@ -70,13 +100,15 @@ def shortest_path(request):
         data = json.loads(request.body)
         start = data.get('start')
         end = data.get('end')
+        mode = SEARCH_MODES.get(data.get('mode', 'dijkstra'), pathfinder.SearchMode.DIJKSTRA)
         
-        result = pf.find_shortest_path(start, end)
+        result = pf.find_shortest_path(start, end, mode)
         return JsonResponse({
             'found': result.found,
             'path': result.path,
             'distance': result.distance,
-            'message': result.message
+            'message': result.message,
+            'settledNodes': result.settledNodes
         })
     return JsonResponse({'found': False, 'message': 'Invalid request'})
 
@@ -87,12 +119,14 @@ def longest_path(request):
         data = json.loads(request.body)
         start = data.get('start')
         end = data.get('end')
+        time_budget_ms = int(data.get('timeBudgetMs', 1000))
         
-        result = pf.find_longest_path(start, end)
+        result = pf.find_longest_path(start, end, time_budget_ms)
         return JsonResponse({
             'found': result.found,
             'path': result.path,
             'distance': result.distance,
+            'provenLongest': result.provenLongest,
             'message': result.message
         })
     return JsonResponse({'found': False, 'message': 'Invalid request'})
@@ -134,19 +168,22 @@ def multi_city_tour(request):
     if request.method == 'POST':
         data = json.loads(request.body)
         cities = data.get('cities', [])
+        time_budget_ms = int(data.get('timeBudgetMs', 1000))
         
-        result = pf.plan_multi_city_tour(cities)
+        result = pf.plan_multi_city_tour(cities, time_budget_ms)
         return JsonResponse({
             'found': result.found,
             'path': result.path,
             'totalDistance': result.totalDistance,
+            'provenOptimal': result.provenOptimal,
             'message': result.message
         })
     return JsonResponse({'found': False, 'message': 'Invalid request'})
 
 def cheapest_network(request):
     """Find the cheapest network (MST)"""
-    result = pf.find_cheapest_network()
+    algorithm = MST_ALGORITHMS.get(request.GET.get('algorithm', 'auto'), pathfinder.MSTAlgorithm.AUTO)
+    result = pf.find_cheapest_network(algorithm)
     return JsonResponse({
         'found': result.found,
         'edges': result.edges,
@@ -267,8 +304,8 @@ def load_sample(request):
             ('San Francisco', 'Seattle', 808),
         ]
         
-        for city1, city2, distance in sample_routes:
-            pf.add_city(city1, city2, distance)
+        sources, destinations, distances = zip(*sample_routes)
+        pf.load_edges(list(sources), list(destinations), list(distances))
         
         return JsonResponse({
             'success': True,
@@ -4,68 +4,22 @@
 #include <string>
 #include <climits>
 #include <algorithm>
+#include "cpp_src/include/DataStructures.h"
 
 using namespace std;
 
-// --- Custom Linked List based Stack for DFS & Path Reconstruction ---
-template <typename T>
-class CustomStack {
-private:
-    struct Node { T data; Node* next; };
-    Node* topNode;
-public:
-    CustomStack() : topNode(nullptr) {}
-    void push(T val) { topNode = new Node{val, topNode}; }
-    void pop() {
-        if (topNode) {
-            Node* t = topNode;
-            topNode = topNode->next;
-            delete t;
-        }
-    }
-    T top() { return topNode->data; }
-    bool empty() { return topNode == nullptr; }
-    ~CustomStack() { while (!empty()) pop(); }
-};
-
-// --- Custom Linked List based Queue for BFS ---
-template <typename T>
-class CustomQueue {
-private:
-    struct Node { T data; Node* next; };
-    Node *frontNode, *rearNode;
-public:
-    CustomQueue() : frontNode(nullptr), rearNode(nullptr) {}
-    void enqueue(T val) {
-        Node* newNode = new Node{val, nullptr};
-        if (!rearNode) { frontNode = rearNode = newNode; return; }
-        rearNode->next = newNode; rearNode = newNode;
-    }
-    void dequeue() {
-        if (frontNode) {
-            Node* t = frontNode;
-            frontNode = frontNode->next;
-            if (!frontNode) rearNode = nullptr;
-            delete t;
-        }
-    }
-    T front() { return frontNode->data; }
-    bool empty() { return frontNode == nullptr; }
-    ~CustomQueue() { while (!empty()) dequeue(); }
-};
-
 // --- Min-Priority Queue for Dijkstra/Prim ---
-struct PQNode { int weight; string city; };
+struct CityPQNode { int weight; string city; };
 class MinPQ {
-    vector<PQNode> heap;
+    vector<CityPQNode> heap;
 public:
     void push(int w, string c) {
         heap.push_back({w, c});
-        push_heap(heap.begin(), heap.end(), [](PQNode a, PQNode b) { return a.weight > b.weight; });
+        push_heap(heap.begin(), heap.end(), [](CityPQNode a, CityPQNode b) { return a.weight > b.weight; });
     }
-    PQNode pop() {
-        pop_heap(heap.begin(), heap.end(), [](PQNode a, PQNode b) { return a.weight > b.weight; });
-        PQNode top = heap.back(); heap.pop_back();
+    CityPQNode pop() {
+        pop_heap(heap.begin(), heap.end(), [](CityPQNode a, CityPQNode b) { return a.weight > b.weight; });
+        CityPQNode top = heap.back(); heap.pop_back();
         return top;
     }
     bool empty() { return heap.empty(); }
@@ -128,7 +82,7 @@ public:
         pq.push(0, start);
 
         while (!pq.empty()) {
-            PQNode top = pq.pop();
+            CityPQNode top = pq.pop();
             if (top.weight > dist[top.city]) continue;
             if (top.city == end) break;
 
@@ -162,7 +116,7 @@ public:
         visited[start] = true;
 
         while (!q.empty()) {
-            string u = q.front(); q.dequeue();
+            string u = move(q.front()); q.dequeue();
             if (u == end) {
                 cout << "Route with fewest stops: "; printPath(parent, end);
                 cout << endl;
@@ -195,7 +149,7 @@ public:
         s.push(start);
         cout << "Reachable: ";
         while (!s.empty()) {
-            string u = s.top(); s.pop();
+            string u = move(s.top()); s.pop();
             if (!visited[u]) {
                 visited[u] = true;
                 cout << u << " ";
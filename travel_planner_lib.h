@@ -8,68 +8,23 @@
 #include <algorithm>
 #include <sstream>
 #include <memory>
+#include <mutex>
+#include "cpp_src/include/DataStructures.h"
 
 using namespace std;
 
-// --- Custom Linked List based Stack for DFS & Path Reconstruction ---
-template <typename T>
-class CustomStack {
-private:
-    struct Node { T data; Node* next; };
-    Node* topNode;
-public:
-    CustomStack() : topNode(nullptr) {}
-    void push(T val) { topNode = new Node{val, topNode}; }
-    void pop() {
-        if (topNode) {
-            Node* t = topNode;
-            topNode = topNode->next;
-            delete t;
-        }
-    }
-    T top() { return topNode->data; }
-    bool empty() { return topNode == nullptr; }
-    ~CustomStack() { while (!empty()) pop(); }
-};
-
-// --- Custom Linked List based Queue for BFS ---
-template <typename T>
-class CustomQueue {
-private:
-    struct Node { T data; Node* next; };
-    Node *frontNode, *rearNode;
-public:
-    CustomQueue() : frontNode(nullptr), rearNode(nullptr) {}
-    void enqueue(T val) {
-        Node* newNode = new Node{val, nullptr};
-        if (!rearNode) { frontNode = rearNode = newNode; return; }
-        rearNode->next = newNode; rearNode = newNode;
-    }
-    void dequeue() {
-        if (frontNode) {
-            Node* t = frontNode;
-            frontNode = frontNode->next;
-            if (!frontNode) rearNode = nullptr;
-            delete t;
-        }
-    }
-    T front() { return frontNode->data; }
-    bool empty() { return frontNode == nullptr; }
-    ~CustomQueue() { while (!empty()) dequeue(); }
-};
-
 // --- Min-Priority Queue for Dijkstra/Prim ---
-struct PQNode { int weight; string city; };
+struct CityPQNode { int weight; string city; };
 class MinPQ {
-    vector<PQNode> heap;
+    vector<CityPQNode> heap;
 public:
     void push(int w, string c) {
         heap.push_back({w, c});
-        push_heap(heap.begin(), heap.end(), [](PQNode a, PQNode b) { return a.weight > b.weight; });
+        push_heap(heap.begin(), heap.end(), [](CityPQNode a, CityPQNode b) { return a.weight > b.weight; });
     }
-    PQNode pop() {
-        pop_heap(heap.begin(), heap.end(), [](PQNode a, PQNode b) { return a.weight > b.weight; });
-        PQNode top = heap.back(); heap.pop_back();
+    CityPQNode pop() {
+        pop_heap(heap.begin(), heap.end(), [](CityPQNode a, CityPQNode b) { return a.weight > b.weight; });
+        CityPQNode top = heap.back(); heap.pop_back();
         return top;
     }
     bool empty() { return heap.empty(); }
@@ -102,6 +57,11 @@ struct MapStats {
 class TravelPlannerLib {
 private:
     map<string, vector<Edge>> adjList;
+    // Every public call holds this, so the bindings can run without the GIL;
+    // queries insert into adjList through operator[] and cannot share it
+    mutex lock;
+    // Id of the last change set applied through applyChanges; 0 for a fresh map
+    long long version = 0;
 
     // Helper to build path from parent map
     vector<string> buildPath(map<string, string>& parent, const string& current) {
@@ -118,11 +78,37 @@ private:
         return path;
     }
 
+    // Drops every from -> to entry, and the city itself once it has no routes left
+    bool eraseEdge(const string& from, const string& to) {
+        auto city = adjList.find(from);
+        if (city == adjList.end()) return false;
+        auto& edges = city->second;
+        size_t before = edges.size();
+        edges.erase(remove_if(edges.begin(), edges.end(),
+                              [&](const Edge& e) { return e.dest == to; }),
+                    edges.end());
+        bool found = edges.size() != before;
+        if (edges.empty()) adjList.erase(city);
+        return found;
+    }
+
+    // Sets the from -> to distance, adding the entry if it is missing
+    void setEdge(const string& from, const string& to, int w) {
+        for (auto& e : adjList[from]) {
+            if (e.dest == to) {
+                e.weight = w;
+                return;
+            }
+        }
+        adjList[from].push_back({to, w});
+    }
+
 public:
     TravelPlannerLib() {}
 
     // Add a route between two cities
     RouteOperationResult addRoute(const string& u, const string& v, int w) {
+        lock_guard<mutex> guard(lock);
         RouteOperationResult result;
         
         if (w <= 0) {
@@ -141,6 +127,7 @@ public:
 
     // Delete a route between two cities
     RouteOperationResult deleteRoute(const string& u, const string& v) {
+        lock_guard<mutex> guard(lock);
         RouteOperationResult result;
         
         auto removeEdge = [&](const string& from, const string& to) -> bool {
@@ -168,6 +155,7 @@ public:
 
     // Find shortest path using Dijkstra's algorithm
     PathResult findShortestPath(const string& start, const string& end) {
+        lock_guard<mutex> guard(lock);
         PathResult result;
         
         if (adjList.find(start) == adjList.end() || adjList.find(end) == adjList.end()) {
@@ -185,7 +173,7 @@ public:
         pq.push(0, start);
 
         while (!pq.empty()) {
-            PQNode top = pq.pop();
+            CityPQNode top = pq.pop();
             if (top.weight > dist[top.city]) continue;
             if (top.city == end) break;
 
@@ -213,6 +201,7 @@ public:
 
     // Find path with fewest stops using BFS
     PathResult findFewestStops(const string& start, const string& end) {
+        lock_guard<mutex> guard(lock);
         PathResult result;
         
         if (adjList.find(start) == adjList.end() || adjList.find(end) == adjList.end()) {
@@ -229,7 +218,7 @@ public:
         visited[start] = true;
 
         while (!q.empty()) {
-            string u = q.front(); 
+            string u = move(q.front());
             q.dequeue();
             
             if (u == end) {
@@ -256,6 +245,7 @@ public:
 
     // Get all reachable cities from a starting point
     vector<string> getReachableCities(const string& start) {
+        lock_guard<mutex> guard(lock);
         vector<string> reachable;
         
         if (adjList.find(start) == adjList.end()) {
@@ -267,7 +257,7 @@ public:
         s.push(start);
         
         while (!s.empty()) {
-            string u = s.top();
+            string u = move(s.top());
             s.pop();
             
             if (!visited[u]) {
@@ -286,6 +276,7 @@ public:
 
     // Get map statistics
     MapStats getMapStats() {
+        lock_guard<mutex> guard(lock);
         MapStats stats;
         stats.totalCities = adjList.size();
         stats.totalRoutes = 0;
@@ -300,6 +291,7 @@ public:
 
     // Get all cities
     vector<string> getAllCities() {
+        lock_guard<mutex> guard(lock);
         vector<string> cities;
         for (auto const& [city, _] : adjList) {
             cities.push_back(city);
@@ -309,6 +301,7 @@ public:
 
     // Get all routes
     vector<tuple<string, string, int>> getAllRoutes() {
+        lock_guard<mutex> guard(lock);
         vector<tuple<string, string, int>> routes;
         map<pair<string, string>, bool> added;
         
@@ -333,7 +326,49 @@ public:
 
     // Clear all data
     void clear() {
+        lock_guard<mutex> guard(lock);
         adjList.clear();
+        version = 0;
+    }
+
+    // Version recorded by the last applyChanges call (0 after clear)
+    long long getVersion() {
+        lock_guard<mutex> guard(lock);
+        return version;
+    }
+
+    // Apply a whole change set in one call: every upsert sets the route's
+    // distance (adding the route if missing), every deletion removes the
+    // route if present. The map then records `newVersion`.
+    RouteOperationResult applyChanges(const vector<tuple<string, string, int>>& upserts,
+                                      const vector<pair<string, string>>& deletions,
+                                      long long newVersion) {
+        lock_guard<mutex> guard(lock);
+        RouteOperationResult result;
+
+        // Reject the whole set up front so a bad row never leaves it half applied
+        for (const auto& [u, v, w] : upserts) {
+            if (w <= 0 || u == v) {
+                result.success = false;
+                result.message = "Error: Invalid route " + u + " <-> " + v + "; no changes applied.";
+                return result;
+            }
+        }
+
+        for (const auto& [u, v, w] : upserts) {
+            setEdge(u, v, w);
+            setEdge(v, u, w);
+        }
+        for (const auto& [u, v] : deletions) {
+            eraseEdge(u, v);
+            eraseEdge(v, u);
+        }
+
+        version = newVersion;
+        result.success = true;
+        result.message = "Applied " + to_string(upserts.size()) + " route updates and " +
+                         to_string(deletions.size()) + " deletions.";
+        return result;
     }
 };
 